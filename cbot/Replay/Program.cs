@@ -0,0 +1,54 @@
+using System;
+using System.Diagnostics;
+using System.IO;
+using BenchmarkDotNet.Running;
+using cAlgo.Robots;
+
+namespace StatArbReplay
+{
+    /// <summary>
+    /// Offline replay host for StatisticalArbitrageBot.
+    ///
+    ///   dotnet run -c Release -- replay [ticks.csv] [--log]
+    ///   dotnet run -c Release -- bench
+    /// </summary>
+    public static class Program
+    {
+        public static int Main(string[] args)
+        {
+            var mode = args.Length > 0 ? args[0] : "replay";
+
+            if (mode == "bench")
+            {
+                BenchmarkRunner.Run<ReplayBenchmarks>();
+                return 0;
+            }
+
+            if (mode != "replay")
+            {
+                Console.Error.WriteLine("Usage: StatArbReplay replay [ticks.csv] [--log] | bench");
+                return 1;
+            }
+
+            var path = args.Length > 1 && !args[1].StartsWith("--") ? args[1] : null;
+            var verbose = Array.IndexOf(args, "--log") >= 0;
+
+            var ticks = path != null ? ReplayTicks.Load(path) : ReplayTicks.Synthetic(200000);
+            Console.WriteLine($"📂 Loaded {ticks.Length} ticks from {path ?? "synthetic generator"}");
+
+            var stopwatch = Stopwatch.StartNew();
+            var result = ReplayRunner.Run(ticks, ReplayRunner.DefaultSettings(), "SYMBOL_A", "SYMBOL_B",
+                                          log: verbose ? Console.Out : TextWriter.Null);
+            stopwatch.Stop();
+
+            double seconds = stopwatch.Elapsed.TotalSeconds;
+            Console.WriteLine($"⏱️  Replayed in {seconds:F3}s ({result.Ticks / Math.Max(seconds, 1e-9):F0} ticks/s)");
+            Console.WriteLine($"📈 Orders filled: {result.OrdersFilled} ({result.OrdersFilled / 2} pair trades), " +
+                              $"positions closed: {result.PositionsClosed}");
+            if (result.OrdersFilled == 0)
+                Console.WriteLine("⚠️ No orders filled - entries were skipped or rejected (rerun with --log)");
+            Console.WriteLine($"💰 Balance: {result.StartingBalance:F2} -> {result.FinalBalance:F2}");
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+using System;
+using BenchmarkDotNet.Attributes;
+using cAlgo.Robots;
+
+namespace StatArbReplay
+{
+    /// <summary>
+    /// BenchmarkDotNet harness for the strategy's per-tick decision path.
+    /// Set STATARB_TICKS to a recorded tick CSV; synthetic ticks are used otherwise.
+    /// </summary>
+    [MemoryDiagnoser]
+    public class ReplayBenchmarks
+    {
+        private PairTick[] _ticks;
+
+        [Params(50, 500)]
+        public int WindowSize;
+
+        [Params(false, true)]
+        public bool UseQuantileThresholds;
+
+        [Params(false, true)]
+        public bool UseBreakdownMonitor;
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            var path = Environment.GetEnvironmentVariable("STATARB_TICKS");
+            _ticks = string.IsNullOrEmpty(path) ? ReplayTicks.Synthetic(200000) : ReplayTicks.Load(path);
+        }
+
+        [Benchmark]
+        public ReplayResult Replay()
+        {
+            var settings = ReplayRunner.DefaultSettings();
+            settings.WindowSize = WindowSize;
+            settings.UseQuantileThresholds = UseQuantileThresholds;
+            settings.UseBreakdownMonitor = UseBreakdownMonitor;
+            return ReplayRunner.Run(_ticks, settings, "EURUSD", "USDCHF");
+        }
+    }
+}
@@ -0,0 +1,118 @@
+using System;
+using System.Collections.Generic;
+using System.Globalization;
+using System.IO;
+
+namespace StatArbReplay
+{
+    public struct PairTick
+    {
+        public DateTime Time;
+        public double BidA;
+        public double AskA;
+        public double BidB;
+        public double AskB;
+    }
+
+    public static class ReplayTicks
+    {
+        /// <summary>
+        /// Load recorded ticks. Accepts either
+        ///   timestamp,bid_a,ask_a,bid_b,ask_b
+        /// or the PriceDataExtractorBot export
+        ///   timestamp,close_a,close_b
+        /// in which case quotes are built around the close with halfSpread.
+        /// </summary>
+        public static PairTick[] Load(string path, double halfSpread = 0.00005)
+        {
+            var ticks = new List<PairTick>();
+
+            using (var reader = new StreamReader(path))
+            {
+                var header = reader.ReadLine();
+                if (header == null)
+                    return ticks.ToArray();
+
+                string line;
+                while ((line = reader.ReadLine()) != null)
+                {
+                    if (line.Length == 0)
+                        continue;
+
+                    var fields = line.Split(',');
+                    var time = DateTime.Parse(fields[0], CultureInfo.InvariantCulture);
+
+                    if (fields.Length >= 5)
+                    {
+                        ticks.Add(new PairTick
+                        {
+                            Time = time,
+                            BidA = Parse(fields[1]),
+                            AskA = Parse(fields[2]),
+                            BidB = Parse(fields[3]),
+                            AskB = Parse(fields[4])
+                        });
+                    }
+                    else if (fields.Length == 3)
+                    {
+                        double closeA = Parse(fields[1]);
+                        double closeB = Parse(fields[2]);
+                        ticks.Add(new PairTick
+                        {
+                            Time = time,
+                            BidA = closeA - halfSpread,
+                            AskA = closeA + halfSpread,
+                            BidB = closeB - halfSpread,
+                            AskB = closeB + halfSpread
+                        });
+                    }
+                }
+            }
+
+            return ticks.ToArray();
+        }
+
+        /// <summary>
+        /// Generate a cointegrated pair with an Ornstein-Uhlenbeck spread,
+        /// for profiling when no recording is at hand.
+        /// </summary>
+        public static PairTick[] Synthetic(int count, double hedgeRatio = 0.85, int seed = 42)
+        {
+            var random = new Random(seed);
+            var ticks = new PairTick[count];
+            var time = new DateTime(2025, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+            double priceB = 0.8750;
+            double spread = 0;
+
+            for (int i = 0; i < count; i++)
+            {
+                priceB += 0.00002 * Gaussian(random);
+                spread = 0.98 * spread + 0.00003 * Gaussian(random);
+                double priceA = 0.3 + hedgeRatio * priceB + spread;
+
+                ticks[i] = new PairTick
+                {
+                    Time = time.AddSeconds(i),
+                    BidA = priceA - 0.00005,
+                    AskA = priceA + 0.00005,
+                    BidB = priceB - 0.00005,
+                    AskB = priceB + 0.00005
+                };
+            }
+
+            return ticks;
+        }
+
+        private static double Parse(string value)
+        {
+            return double.Parse(value, CultureInfo.InvariantCulture);
+        }
+
+        private static double Gaussian(Random random)
+        {
+            double u1 = 1.0 - random.NextDouble();
+            double u2 = random.NextDouble();
+            return Math.Sqrt(-2.0 * Math.Log(u1)) * Math.Cos(2.0 * Math.PI * u2);
+        }
+    }
+}
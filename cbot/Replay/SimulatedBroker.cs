@@ -0,0 +1,174 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using cAlgo.Robots;
+
+namespace StatArbReplay
+{
+    public class SimulatedMarket : IPairMarket
+    {
+        public SimulatedMarket(string name, double pipSize = 0.0001, double volumeStep = 1000, double leverage = 30)
+        {
+            Name = name;
+            PipSize = pipSize;
+            VolumeInUnitsMin = volumeStep;
+            VolumeStep = volumeStep;
+            Leverage = leverage;
+        }
+
+        public string Name { get; }
+        public double Bid { get; set; }
+        public double Ask { get; set; }
+        public double PipSize { get; }
+        public double VolumeInUnitsMin { get; }
+        public double VolumeStep { get; }
+        public double Leverage { get; }
+
+        public double GetEstimatedMargin(TradeSide side, double volume)
+        {
+            double price = side == TradeSide.Buy ? Ask : Bid;
+            return volume * price / Leverage;
+        }
+
+        public double NormalizeVolumeDown(double volume)
+        {
+            return Math.Floor(volume / VolumeStep) * VolumeStep;
+        }
+    }
+
+    /// <summary>
+    /// In-memory account that fills market orders at the current quote and
+    /// enforces stop losses on each tick. Profit is in quote currency units.
+    /// </summary>
+    public class SimulatedBroker : IStrategyHost
+    {
+        private class SimPosition
+        {
+            public string Label;
+            public TradeSide Side;
+            public SimulatedMarket Market;
+            public long Volume;
+            public double EntryPrice;
+            public double? StopLoss;
+
+            public double ExitPrice => Side == TradeSide.Buy ? Market.Bid : Market.Ask;
+            public double NetProfit => (ExitPrice - EntryPrice) * Volume * (Side == TradeSide.Buy ? 1 : -1);
+            public double Margin => Volume * EntryPrice / Market.Leverage;
+        }
+
+        private readonly List<SimPosition> _positions = new List<SimPosition>();
+        private readonly TextWriter _log;
+        private double _balance;
+
+        public SimulatedBroker(double balance, TextWriter log = null)
+        {
+            _balance = balance;
+            _log = log;
+        }
+
+        public DateTime Now { get; set; }
+        public int OrdersFilled { get; private set; }
+        public int PositionsClosed { get; private set; }
+        public double Balance => _balance;
+
+        public double Equity
+        {
+            get
+            {
+                double equity = _balance;
+                foreach (var position in _positions)
+                    equity += position.NetProfit;
+                return equity;
+            }
+        }
+
+        public double FreeMargin
+        {
+            get
+            {
+                double used = 0;
+                foreach (var position in _positions)
+                    used += position.Margin;
+                return Equity - used;
+            }
+        }
+
+        public OrderResult ExecuteMarketOrder(TradeSide side, IPairMarket market, long volume, string label)
+        {
+            var simMarket = (SimulatedMarket)market;
+            _positions.Add(new SimPosition
+            {
+                Label = label,
+                Side = side,
+                Market = simMarket,
+                Volume = volume,
+                EntryPrice = side == TradeSide.Buy ? simMarket.Ask : simMarket.Bid
+            });
+            OrdersFilled++;
+            return new OrderResult { IsSuccessful = true };
+        }
+
+        public double NetProfit(string label)
+        {
+            double total = 0;
+            foreach (var position in _positions)
+                if (position.Label == label)
+                    total += position.NetProfit;
+            return total;
+        }
+
+        public bool HasPositions(string label)
+        {
+            return _positions.Exists(p => p.Label == label);
+        }
+
+        public void ClosePositions(string label)
+        {
+            for (int i = _positions.Count - 1; i >= 0; i--)
+            {
+                if (_positions[i].Label == label)
+                    Close(i);
+            }
+        }
+
+        public void SetStopLossAtMarket(string label, IPairMarket market)
+        {
+            foreach (var position in _positions)
+            {
+                if (position.Label == label)
+                    position.StopLoss = position.Side == TradeSide.Buy ? market.Bid : market.Ask;
+            }
+        }
+
+        /// <summary>
+        /// Close positions whose stop loss was crossed by the current quote.
+        /// </summary>
+        public void ProcessStops()
+        {
+            for (int i = _positions.Count - 1; i >= 0; i--)
+            {
+                var position = _positions[i];
+                if (position.StopLoss == null)
+                    continue;
+
+                bool hit = position.Side == TradeSide.Buy
+                    ? position.Market.Bid <= position.StopLoss.Value
+                    : position.Market.Ask >= position.StopLoss.Value;
+                if (hit)
+                    Close(i);
+            }
+        }
+
+        public void Print(string message)
+        {
+            _log?.WriteLine($"{Now:yyyy-MM-dd HH:mm:ss} {message}");
+        }
+
+        private void Close(int index)
+        {
+            _balance += _positions[index].NetProfit;
+            _positions.RemoveAt(index);
+            PositionsClosed++;
+        }
+    }
+}
@@ -0,0 +1,824 @@
+using System;
+using System.Collections.Generic;
+using System.Linq;
+
+// Platform-independent core of StatisticalArbitrageBot. Nothing in this file
+// references cAlgo.API, so the same signal, sizing and exit logic runs inside
+// cTrader (via CTraderStrategyHost) and in the offline replay host (cbot/Replay).
+namespace cAlgo.Robots
+{
+    public enum TradeSide
+    {
+        Buy,
+        Sell
+    }
+
+    public class RollingWindow
+    {
+        private readonly Queue<double> _values;
+        private readonly int _windowSize;
+        private double _sum;
+
+        public RollingWindow(int windowSize)
+        {
+            _windowSize = windowSize;
+            _values = new Queue<double>();
+            _sum = 0;
+        }
+
+        public void Add(double value)
+        {
+            _values.Enqueue(value);
+            _sum += value;
+
+            if (_values.Count > _windowSize)
+            {
+                _sum -= _values.Dequeue();
+            }
+        }
+
+        public double Mean => _values.Count > 0 ? _sum / _values.Count : 0;
+
+        public double StandardDeviation
+        {
+            get
+            {
+                if (_values.Count < 2) return 0;
+
+                var mean = Mean;
+                var sumSquaredDifferences = _values.Sum(x => Math.Pow(x - mean, 2));
+                return Math.Sqrt(sumSquaredDifferences / (_values.Count - 1));
+            }
+        }
+
+        public int Count => _values.Count;
+
+        public bool IsFull => _values.Count >= _windowSize;
+    }
+
+    /// <summary>
+    /// Streaming P² (Jain &amp; Chlamtac) estimator for a single quantile.
+    /// Keeps five markers, so memory and per-update cost are O(1).
+    /// </summary>
+    public class P2QuantileEstimator
+    {
+        private readonly double _p;
+        private readonly double[] _heights = new double[5];
+        private readonly int[] _positions = new int[5];
+        private readonly double[] _desired = new double[5];
+        private readonly double[] _increments = new double[5];
+        private int _count;
+
+        public P2QuantileEstimator(double p)
+        {
+            _p = p;
+            _increments[0] = 0;
+            _increments[1] = p / 2;
+            _increments[2] = p;
+            _increments[3] = (1 + p) / 2;
+            _increments[4] = 1;
+        }
+
+        public void Add(double value)
+        {
+            if (_count < 5)
+            {
+                _heights[_count++] = value;
+                if (_count == 5)
+                {
+                    Array.Sort(_heights);
+                    for (int i = 0; i < 5; i++)
+                        _positions[i] = i;
+                    _desired[0] = 0;
+                    _desired[1] = 2 * _p;
+                    _desired[2] = 4 * _p;
+                    _desired[3] = 2 + 2 * _p;
+                    _desired[4] = 4;
+                }
+                return;
+            }
+
+            int cell;
+            if (value < _heights[0])
+            {
+                _heights[0] = value;
+                cell = 0;
+            }
+            else if (value < _heights[1]) cell = 0;
+            else if (value < _heights[2]) cell = 1;
+            else if (value < _heights[3]) cell = 2;
+            else if (value <= _heights[4]) cell = 3;
+            else
+            {
+                _heights[4] = value;
+                cell = 3;
+            }
+
+            for (int i = cell + 1; i < 5; i++)
+                _positions[i]++;
+            for (int i = 0; i < 5; i++)
+                _desired[i] += _increments[i];
+
+            for (int i = 1; i <= 3; i++)
+            {
+                double offset = _desired[i] - _positions[i];
+                if ((offset >= 1 && _positions[i + 1] - _positions[i] > 1) ||
+                    (offset <= -1 && _positions[i - 1] - _positions[i] < -1))
+                {
+                    int step = Math.Sign(offset);
+                    double candidate = Parabolic(i, step);
+                    _heights[i] = _heights[i - 1] < candidate && candidate < _heights[i + 1]
+                        ? candidate
+                        : Linear(i, step);
+                    _positions[i] += step;
+                }
+            }
+
+            _count++;
+        }
+
+        public int Count => _count;
+
+        public double Value
+        {
+            get
+            {
+                if (_count >= 5)
+                    return _heights[2];
+                if (_count == 0)
+                    return 0;
+
+                var sorted = _heights.Take(_count).OrderBy(x => x).ToArray();
+                return sorted[(int)Math.Round(_p * (_count - 1))];
+            }
+        }
+
+        private double Parabolic(int i, int step)
+        {
+            double span = _positions[i + 1] - _positions[i - 1];
+            double right = (_positions[i] - _positions[i - 1] + step) * (_heights[i + 1] - _heights[i]) / (_positions[i + 1] - _positions[i]);
+            double left = (_positions[i + 1] - _positions[i] - step) * (_heights[i] - _heights[i - 1]) / (_positions[i] - _positions[i - 1]);
+            return _heights[i] + step / span * (right + left);
+        }
+
+        private double Linear(int i, int step)
+        {
+            return _heights[i] + step * (_heights[i + step] - _heights[i]) / (_positions[i + step] - _positions[i]);
+        }
+    }
+
+    /// <summary>
+    /// Streaming cointegration breakdown detector for one pair, O(1) per tick.
+    /// The spread is standardized by a reference mean and deviation (from
+    /// test_cointegration, or calibrated over the first ticks). Three checks
+    /// then run on every tick:
+    /// a two-sided CUSUM on the standardized spread (level shift),
+    /// Page-Hinkley on its square (variance growth, i.e. loss of stationarity),
+    /// and an exponentially weighted hedge ratio against the configured one.
+    /// Tick spreads are strongly autocorrelated, so the CUSUM and Page-Hinkley
+    /// thresholds are in correlation times 1 / (1 - rho), with rho the lag-1
+    /// autocorrelation measured during calibration. An alarm latches until Reset().
+    /// </summary>
+    public class BreakdownMonitor
+    {
+        private readonly StatArbSettings _settings;
+        private readonly double _decay;
+        private int _count;
+        private double _first;
+        private double _previous;
+        private double _sum;
+        private double _sumSquares;
+        private double _sumLagged;
+        private double _refMean;
+        private double _refStd;
+        private double _meanA;
+        private double _meanB;
+        private double _covAB;
+        private double _varB;
+        private double _pageHinkleySum;
+        private double _pageHinkleyMin;
+
+        public BreakdownMonitor(StatArbSettings settings)
+        {
+            _settings = settings;
+            _decay = Math.Pow(0.5, 1.0 / Math.Max(settings.HedgeDriftHalfLife, 1));
+            Reset();
+        }
+
+        public bool IsBroken { get; private set; }
+        public string Reason { get; private set; }
+        public bool IsCalibrated { get; private set; }
+        public double CorrelationTime { get; private set; }
+        public double CusumHigh { get; private set; }
+        public double CusumLow { get; private set; }
+        public double VarianceStatistic { get; private set; }
+        public double HedgeRatioEstimate => _varB > 0 ? _covAB / _varB : double.NaN;
+
+        /// <summary>
+        /// Clears alarms and statistics and restarts calibration.
+        /// </summary>
+        public void Reset()
+        {
+            IsBroken = false;
+            Reason = null;
+            IsCalibrated = false;
+            CorrelationTime = 1;
+            CusumHigh = 0;
+            CusumLow = 0;
+            VarianceStatistic = 0;
+            _pageHinkleySum = 0;
+            _pageHinkleyMin = 0;
+            _count = 0;
+            _sum = 0;
+            _sumSquares = 0;
+            _sumLagged = 0;
+            _covAB = 0;
+            _varB = 0;
+        }
+
+        /// <summary>
+        /// Feeds one tick of leg mid prices; returns true on the tick the alarm trips.
+        /// </summary>
+        public bool Add(double priceA, double priceB)
+        {
+            var s = _settings;
+            _count++;
+            UpdateHedgeRatio(priceA, priceB);
+
+            double spread = priceA - s.HedgeRatio * priceB;
+
+            if (!IsCalibrated)
+            {
+                Calibrate(spread);
+                return false;
+            }
+
+            if (IsBroken)
+                return false;
+
+            double z = (spread - _refMean) / _refStd;
+
+            CusumHigh = Math.Max(0, CusumHigh + z - s.CusumDrift);
+            CusumLow = Math.Max(0, CusumLow - z - s.CusumDrift);
+
+            // Page-Hinkley for an increase in E[z^2] above 1 + drift
+            _pageHinkleySum += z * z - 1 - s.VarianceDrift;
+            _pageHinkleyMin = Math.Min(_pageHinkleyMin, _pageHinkleySum);
+            VarianceStatistic = _pageHinkleySum - _pageHinkleyMin;
+
+            double cusumLimit = s.CusumThreshold * CorrelationTime;
+            double varianceLimit = s.VarianceThreshold * CorrelationTime;
+            if (CusumHigh > cusumLimit || CusumLow > cusumLimit)
+                return Trip($"spread level shift (CUSUM {Math.Max(CusumHigh, CusumLow):F0} > {cusumLimit:F0})");
+            if (VarianceStatistic > varianceLimit)
+                return Trip($"spread variance growth (Page-Hinkley {VarianceStatistic:F0} > {varianceLimit:F0})");
+
+            double hedge = HedgeRatioEstimate;
+            if (_count >= s.HedgeDriftHalfLife * 4 && !double.IsNaN(hedge) && s.HedgeRatio != 0 &&
+                Math.Abs(hedge - s.HedgeRatio) > s.MaxHedgeRatioDrift * Math.Abs(s.HedgeRatio))
+                return Trip($"hedge ratio drift ({hedge:F4} vs {s.HedgeRatio:F4})");
+
+            return false;
+        }
+
+        private void Calibrate(double spread)
+        {
+            // Raw moments of the spread shifted by its first value (keeps them well conditioned)
+            if (_count == 1)
+                _first = spread;
+            double x = spread - _first;
+            if (_count > 1)
+                _sumLagged += x * _previous;
+            _sum += x;
+            _sumSquares += x * x;
+            _previous = x;
+
+            if (_count < Math.Max(_settings.BreakdownWarmup, 3))
+                return;
+
+            double mean = _sum / _count;
+            double variance = (_sumSquares - _count * mean * mean) / (_count - 1);
+            double lagged = _sumLagged / (_count - 1) - mean * mean;
+            double rho = variance > 0 ? Math.Min(Math.Max(lagged / variance, 0), 0.9999) : 0;
+            CorrelationTime = 1 / (1 - rho);
+
+            if (_settings.SpreadStd > 0)
+            {
+                _refMean = _settings.SpreadMean;
+                _refStd = _settings.SpreadStd;
+            }
+            else
+            {
+                _refMean = _first + mean;
+                _refStd = Math.Sqrt(Math.Max(variance, 0));
+            }
+            IsCalibrated = _refStd > 0;
+        }
+
+        private void UpdateHedgeRatio(double priceA, double priceB)
+        {
+            // Exponentially weighted regression of A on B around EW means
+            if (_count == 1)
+            {
+                _meanA = priceA;
+                _meanB = priceB;
+                return;
+            }
+
+            double alpha = 1 - _decay;
+            double deltaA = priceA - _meanA;
+            double deltaB = priceB - _meanB;
+            _meanA += alpha * deltaA;
+            _meanB += alpha * deltaB;
+            _covAB = _decay * (_covAB + alpha * deltaA * deltaB);
+            _varB = _decay * (_varB + alpha * deltaB * deltaB);
+        }
+
+        private bool Trip(string reason)
+        {
+            IsBroken = true;
+            Reason = reason;
+            return true;
+        }
+    }
+
+    /// <summary>
+    /// Quote and contract data for one leg of the pair.
+    /// </summary>
+    public interface IPairMarket
+    {
+        string Name { get; }
+        double Bid { get; }
+        double Ask { get; }
+        double PipSize { get; }
+        double VolumeInUnitsMin { get; }
+        double GetEstimatedMargin(TradeSide side, double volume);
+        double NormalizeVolumeDown(double volume);
+    }
+
+    public struct OrderResult
+    {
+        public bool IsSuccessful;
+        public string Error;
+    }
+
+    /// <summary>
+    /// Account, order routing, clock and logging as seen by the strategy.
+    /// Positions are addressed by label, one label per leg.
+    /// </summary>
+    public interface IStrategyHost
+    {
+        DateTime Now { get; }
+        double Equity { get; }
+        double FreeMargin { get; }
+        OrderResult ExecuteMarketOrder(TradeSide side, IPairMarket market, long volume, string label);
+        double NetProfit(string label);
+        bool HasPositions(string label);
+        void ClosePositions(string label);
+        void SetStopLossAtMarket(string label, IPairMarket market);
+        void Print(string message);
+    }
+
+    public class StatArbSettings
+    {
+        public double HedgeRatio = 0.85;
+        public int WindowSize = 50;
+        public double EntryThreshold = 2.0;
+        public double ExitThreshold = 0.5;
+        public double MaxSpreadPips = 2.0;
+        public int Volume = 10000;
+        public double RiskPercent = 1.0;
+        public double MinVolatility = 0.0001;
+        public double VolScalingFactor = 1.0;
+        public int MaxVolume = 0;
+        public string Label = "StatArb";
+        public int MaxTradeDurationMinutes = 30;
+        public bool UseQuantileThresholds = false;
+        public double EntryQuantile = 0.975;
+        public double ExitQuantile = 0.65;
+        public int QuantileWarmup = 500;
+        // Cointegration breakdown monitor: blocks new entries once it trips.
+        // Drifts are in reference standard deviations (CUSUM) and units of
+        // z^2 (Page-Hinkley); thresholds are in spread correlation times
+        public bool UseBreakdownMonitor = false;
+        public double SpreadMean = 0;         // reference spread mean (intercept); used when SpreadStd > 0
+        public double SpreadStd = 0;          // reference spread std (residual_std); 0 = calibrate
+        public int BreakdownWarmup = 20000;   // calibration ticks (autocorrelation, and mean/std if not given)
+        public double CusumDrift = 2.0;
+        public double CusumThreshold = 20;
+        public double VarianceDrift = 3.0;
+        public double VarianceThreshold = 40;
+        public double MaxHedgeRatioDrift = 0.25;
+        public int HedgeDriftHalfLife = 5000;
+    }
+
+    /// <summary>
+    /// Signal, sizing and exit logic of the pair strategy.
+    /// </summary>
+    public class StatArbStrategy
+    {
+        private readonly StatArbSettings _settings;
+        private readonly IStrategyHost _host;
+        private readonly IPairMarket _symbolAData;
+        private readonly IPairMarket _symbolBData;
+        private readonly RollingWindow _spreadWindow;
+        private readonly P2QuantileEstimator _entryUpper;
+        private readonly P2QuantileEstimator _entryLower;
+        private readonly P2QuantileEstimator _exitUpper;
+        private readonly P2QuantileEstimator _exitLower;
+        private readonly BreakdownMonitor _breakdown;
+        private bool _hasPosition;
+        private TradeSide _currentTradeType;
+        private DateTime _lastLogTime;
+        private DateTime _positionEntryTime;
+        private bool _stopLossSet;
+
+        public StatArbStrategy(StatArbSettings settings, IStrategyHost host, IPairMarket symbolA, IPairMarket symbolB)
+        {
+            _settings = settings;
+            _host = host;
+            _symbolAData = symbolA;
+            _symbolBData = symbolB;
+            _spreadWindow = new RollingWindow(settings.WindowSize);
+            _entryUpper = new P2QuantileEstimator(settings.EntryQuantile);
+            _entryLower = new P2QuantileEstimator(1 - settings.EntryQuantile);
+            _exitUpper = new P2QuantileEstimator(settings.ExitQuantile);
+            _exitLower = new P2QuantileEstimator(1 - settings.ExitQuantile);
+            _breakdown = settings.UseBreakdownMonitor ? new BreakdownMonitor(settings) : null;
+            _hasPosition = false;
+            _lastLogTime = DateTime.MinValue;
+        }
+
+        public bool HasPosition => _hasPosition;
+
+        /// <summary>
+        /// True once the breakdown monitor has tripped; open positions are still
+        /// managed, but no new pair is entered until ResetBreakdownMonitor().
+        /// </summary>
+        public bool EntriesBlocked => _breakdown != null && _breakdown.IsBroken;
+
+        public BreakdownMonitor Breakdown => _breakdown;
+
+        public void ResetBreakdownMonitor()
+        {
+            _breakdown?.Reset();
+            Print("🔓 Breakdown monitor reset - recalibrating, new entries allowed");
+        }
+
+        private string SymbolA => _symbolAData.Name;
+        private string SymbolB => _symbolBData.Name;
+        private string LabelA => _settings.Label + "_A";
+        private string LabelB => _settings.Label + "_B";
+
+        private void Print(string message) => _host.Print(message);
+
+        public void OnStart()
+        {
+            var s = _settings;
+            Print($"🚀 Statistical Arbitrage Bot Started");
+            Print($"📊 Symbol A: {SymbolA}, Symbol B: {SymbolB}");
+            Print($"📈 Hedge Ratio: {s.HedgeRatio}, Window Size: {s.WindowSize}");
+            Print($"🎯 Entry Threshold: {s.EntryThreshold}, Exit Threshold: {s.ExitThreshold}");
+            Print($"💰 Risk Percent: {s.RiskPercent}%, Vol Scaling: {s.VolScalingFactor}");
+            Print($"📏 Max Volume: {(s.MaxVolume > 0 ? s.MaxVolume.ToString() : "Unlimited")}");
+            Print($"⏰ Max Trade Duration: {s.MaxTradeDurationMinutes} minutes");
+            if (s.UseQuantileThresholds)
+                Print($"📐 Quantile Thresholds: Entry {s.EntryQuantile:P2}, Exit {s.ExitQuantile:P2}, Warmup {s.QuantileWarmup} ticks");
+            if (s.UseBreakdownMonitor)
+                Print($"🩺 Breakdown Monitor: CUSUM {s.CusumThreshold}, Page-Hinkley {s.VarianceThreshold}, Hedge Drift {s.MaxHedgeRatioDrift:P0}, " +
+                      $"Calibration {s.BreakdownWarmup} ticks" + (s.SpreadStd > 0 ? $", Reference {s.SpreadMean:F6} ± {s.SpreadStd:F6}" : ""));
+        }
+
+        public void OnTick()
+        {
+            var midPriceA = (_symbolAData.Bid + _symbolAData.Ask) / 2;
+            var midPriceB = (_symbolBData.Bid + _symbolBData.Ask) / 2;
+            var spread = midPriceA - _settings.HedgeRatio * midPriceB;
+
+            _spreadWindow.Add(spread);
+
+            if (_breakdown != null && _breakdown.Add(midPriceA, midPriceB))
+                Print($"🚨 COINTEGRATION BREAKDOWN: {_breakdown.Reason} - new entries blocked");
+
+            if (!_spreadWindow.IsFull)
+                return;
+
+            var mean = _spreadWindow.Mean;
+            var stdDev = _spreadWindow.StandardDeviation;
+
+            if (stdDev == 0)
+                return;
+
+            var zScore = (spread - mean) / stdDev;
+
+            LogSignalData(spread, mean, stdDev, zScore);
+
+            if (_settings.UseQuantileThresholds)
+                UpdateQuantiles(zScore);
+
+            if (_hasPosition)
+            {
+                CheckExitConditions(zScore);
+                CheckTimeBasedExit();
+            }
+            else if (!EntriesBlocked)
+            {
+                CheckEntryConditions(zScore);
+            }
+        }
+
+        public void OnStop()
+        {
+            if (_hasPosition)
+            {
+                Print("🛑 Bot stopping - closing open positions");
+                CloseAllPositions();
+            }
+            Print("🏁 Statistical Arbitrage Bot Stopped");
+        }
+
+        private void UpdateQuantiles(double zScore)
+        {
+            _entryUpper.Add(zScore);
+            _entryLower.Add(zScore);
+            _exitUpper.Add(zScore);
+            _exitLower.Add(zScore);
+        }
+
+        private bool QuantilesReady => _settings.UseQuantileThresholds && _entryUpper.Count >= _settings.QuantileWarmup;
+
+        // Z-score levels for entry/exit: empirical quantiles once warmed up, fixed thresholds otherwise
+        private (double Upper, double Lower) EntryLevels =>
+            QuantilesReady ? (_entryUpper.Value, _entryLower.Value) : (_settings.EntryThreshold, -_settings.EntryThreshold);
+
+        private (double Upper, double Lower) ExitLevels =>
+            QuantilesReady ? (_exitUpper.Value, _exitLower.Value) : (_settings.ExitThreshold, -_settings.ExitThreshold);
+
+        private void CheckEntryConditions(double zScore)
+        {
+            var (upper, lower) = EntryLevels;
+
+            if (zScore <= upper && zScore >= lower)
+                return;
+
+            if (!IsSpreadAcceptable())
+                return;
+
+            // Get the current standard deviation from the spread window
+            double currentStdDev = _spreadWindow.StandardDeviation;
+
+            if (zScore > upper)
+            {
+                ExecutePairTrade(TradeSide.Sell, TradeSide.Buy, currentStdDev);
+                _currentTradeType = TradeSide.Sell;
+                Print($"📉 ENTRY: Short {SymbolA}, Long {SymbolB} | Z-Score: {zScore:F4}");
+            }
+            else if (zScore < lower)
+            {
+                ExecutePairTrade(TradeSide.Buy, TradeSide.Sell, currentStdDev);
+                _currentTradeType = TradeSide.Buy;
+                Print($"📈 ENTRY: Long {SymbolA}, Short {SymbolB} | Z-Score: {zScore:F4}");
+            }
+        }
+
+        private void CheckExitConditions(double zScore)
+        {
+            var (upper, lower) = ExitLevels;
+
+            if (zScore > upper || zScore < lower)
+                return;
+
+            // Use _currentTradeType to provide more specific exit information
+            string tradeDirection = _currentTradeType == TradeSide.Buy ? "LONG" : "SHORT";
+            CloseAllPositions();
+            Print($"🔄 EXIT: {tradeDirection} positions closed | Z-Score: {zScore:F4}");
+        }
+
+        private void CheckTimeBasedExit()
+        {
+            if (!_hasPosition)
+                return;
+
+            var timeSinceEntry = _host.Now.Subtract(_positionEntryTime);
+            if (timeSinceEntry.TotalMinutes < _settings.MaxTradeDurationMinutes)
+                return;
+
+            // Calculate current net profit
+            double totalPnl = _host.NetProfit(LabelA) + _host.NetProfit(LabelB);
+
+            string tradeDirection = _currentTradeType == TradeSide.Buy ? "LONG" : "SHORT";
+
+            if (totalPnl >= 0)
+            {
+                // Profit: Set stop loss at current market price (if not already set)
+                if (!_stopLossSet)
+                {
+                    SetStopLossAtCurrentPrice();
+                    _stopLossSet = true;
+                    Print($"⏰ TIME-BASED STOP LOSS: {tradeDirection} positions | Duration: {timeSinceEntry.TotalMinutes:F1}min | PnL: ${totalPnl:F2}");
+                }
+            }
+            else
+            {
+                // Loss: Immediately close positions
+                CloseAllPositions();
+                Print($"⏰ TIME-BASED EXIT: {tradeDirection} positions closed | Duration: {timeSinceEntry.TotalMinutes:F1}min | PnL: ${totalPnl:F2}");
+            }
+        }
+
+        private void SetStopLossAtCurrentPrice()
+        {
+            try
+            {
+                _host.SetStopLossAtMarket(LabelA, _symbolAData);
+                _host.SetStopLossAtMarket(LabelB, _symbolBData);
+            }
+            catch (Exception ex)
+            {
+                Print($"❌ Stop Loss Set Error: {ex.Message}");
+            }
+        }
+
+        private void ExecutePairTrade(TradeSide tradeTypeA, TradeSide tradeTypeB, double stdDev)
+        {
+            try
+            {
+                // 📌 1. Calculate percentage-of-equity-based capital
+                double capital = _host.Equity * _settings.RiskPercent / 100.0;
+                Print($"💰 Capital allocated: ${capital:F2} ({_settings.RiskPercent}% of ${_host.Equity:F2})");
+
+                // 📌 2. Calculate volumes with margin awareness and volatility scaling
+                var volumes = CalculateVolumes(capital, stdDev, tradeTypeA);
+
+                if (volumes.VolumeA == 0 || volumes.VolumeB == 0)
+                {
+                    Print($"⚠️ Trade skipped: Insufficient volume calculation");
+                    return;
+                }
+
+                // 📌 3. Margin check before execution
+                double marginA = _symbolAData.GetEstimatedMargin(tradeTypeA, volumes.VolumeA);
+                double marginB = _symbolBData.GetEstimatedMargin(tradeTypeB, volumes.VolumeB);
+                double totalMargin = marginA + marginB;
+
+                if (totalMargin > _host.FreeMargin)
+                {
+                    Print($"❌ Trade skipped: Insufficient margin. Required: ${totalMargin:F2}, Available: ${_host.FreeMargin:F2}");
+                    return;
+                }
+
+                // 📌 4. Log trade details
+                Print($"🎯 Executing {tradeTypeA} {SymbolA} / {tradeTypeB} {SymbolB}:");
+                Print($"   💵 Capital: ${capital:F2}");
+                Print($"   📊 Volatility (StdDev): {stdDev:F6}");
+                Print($"   📏 Volume A ({SymbolA}): {volumes.VolumeA}");
+                Print($"   📏 Volume B ({SymbolB}): {volumes.VolumeB}");
+                Print($"   💳 Total Margin: ${totalMargin:F2}");
+
+                // Execute trades
+                var resultA = _host.ExecuteMarketOrder(tradeTypeA, _symbolAData, volumes.VolumeA, LabelA);
+                var resultB = _host.ExecuteMarketOrder(tradeTypeB, _symbolBData, volumes.VolumeB, LabelB);
+
+                if (resultA.IsSuccessful && resultB.IsSuccessful)
+                {
+                    _hasPosition = true;
+                    _positionEntryTime = _host.Now;
+                    _stopLossSet = false;
+                    Print($"✅ Pair trade executed successfully");
+                    Print($"   📈 {SymbolA}: {tradeTypeA} {volumes.VolumeA} @ {(tradeTypeA == TradeSide.Buy ? _symbolAData.Ask : _symbolAData.Bid):F5}");
+                    Print($"   📉 {SymbolB}: {tradeTypeB} {volumes.VolumeB} @ {(tradeTypeB == TradeSide.Buy ? _symbolBData.Ask : _symbolBData.Bid):F5}");
+                    Print($"   ⏰ Entry Time: {_positionEntryTime:HH:mm:ss}");
+                }
+                else
+                {
+                    Print($"❌ Trade execution failed:");
+                    if (!resultA.IsSuccessful)
+                        Print($"   Symbol A Error: {resultA.Error}");
+                    if (!resultB.IsSuccessful)
+                        Print($"   Symbol B Error: {resultB.Error}");
+
+                    // Close any successful position if the other failed
+                    if (resultA.IsSuccessful)
+                        _host.ClosePositions(LabelA);
+                    if (resultB.IsSuccessful)
+                        _host.ClosePositions(LabelB);
+                }
+            }
+            catch (Exception ex)
+            {
+                Print($"❌ ExecutePairTrade Error: {ex.Message}");
+            }
+        }
+
+        private (long VolumeA, long VolumeB) CalculateVolumes(double capital, double stdDev, TradeSide tradeTypeA)
+        {
+            var s = _settings;
+            try
+            {
+                // 📌 2. Estimate margin per unit for both symbols
+                // Convert VolumeInUnitsMin to long explicitly to avoid type conversion issues
+                long minVolumeA = (long)_symbolAData.VolumeInUnitsMin;
+                long minVolumeB = (long)_symbolBData.VolumeInUnitsMin;
+
+                double marginPerUnitA = _symbolAData.GetEstimatedMargin(tradeTypeA, minVolumeA) / minVolumeA;
+                double marginPerUnitB = _symbolBData.GetEstimatedMargin(tradeTypeA == TradeSide.Buy ? TradeSide.Sell : TradeSide.Buy, minVolumeB) / minVolumeB;
+
+                // 📌 3. Volatility-based scaling
+                double volAdjustment = (1.0 / Math.Max(stdDev, s.MinVolatility)) * s.VolScalingFactor;
+
+                // Calculate base volumes considering both symbols' margin requirements and hedge ratio
+                double totalMarginPerUnit = marginPerUnitA + (marginPerUnitB * s.HedgeRatio);
+
+                // Validate margin calculation to avoid division by zero
+                if (totalMarginPerUnit <= 0)
+                {
+                    Print($"⚠️ Invalid margin calculation: {totalMarginPerUnit:F6}");
+                    return (s.Volume, (long)(s.Volume * s.HedgeRatio));
+                }
+
+                double baseVolume = capital / totalMarginPerUnit;
+
+                // Apply volatility adjustment with bounds checking
+                double adjustedVolume = baseVolume * volAdjustment;
+
+                // Apply max volume cap if specified
+                if (s.MaxVolume > 0)
+                {
+                    adjustedVolume = Math.Min(adjustedVolume, (double)s.MaxVolume);
+                }
+
+                // Convert to valid volumes for each symbol with explicit casting
+                long volumeA = (long)_symbolAData.NormalizeVolumeDown(adjustedVolume);
+                long volumeB = (long)_symbolBData.NormalizeVolumeDown(adjustedVolume * s.HedgeRatio);
+
+                // Ensure minimum volumes
+                volumeA = Math.Max(volumeA, minVolumeA);
+                volumeB = Math.Max(volumeB, minVolumeB);
+
+                // Fallback to original logic if calculation fails
+                if (volumeA == 0 || volumeB == 0)
+                {
+                    volumeA = s.Volume;
+                    volumeB = (long)(s.Volume * s.HedgeRatio);
+                    Print($"⚠️ Using fallback volumes: A={volumeA}, B={volumeB}");
+                }
+
+                Print($"📊 Volume Calculation:");
+                Print($"   💰 Base Volume: {baseVolume:F2}");
+                Print($"   📈 Vol Adjustment: {volAdjustment:F4}");
+                Print($"   🎯 Final Volume A: {volumeA}");
+                Print($"   🎯 Final Volume B: {volumeB}");
+
+                return (volumeA, volumeB);
+            }
+            catch (Exception ex)
+            {
+                Print($"❌ Volume Calculation Error: {ex.Message}");
+                // Return fallback volumes
+                return (s.Volume, (long)(s.Volume * s.HedgeRatio));
+            }
+        }
+
+        private void CloseAllPositions()
+        {
+            bool hadPositions = _host.HasPositions(LabelA) || _host.HasPositions(LabelB);
+
+            double totalPnlA = _host.NetProfit(LabelA);
+            double totalPnlB = _host.NetProfit(LabelB);
+            double totalPnl = totalPnlA + totalPnlB;
+
+            _host.ClosePositions(LabelA);
+            _host.ClosePositions(LabelB);
+
+            if (hadPositions)
+            {
+                Print($"💰 Position PnL Summary:");
+                Print($"   📈 {SymbolA} PnL: ${totalPnlA:F2}");
+                Print($"   📉 {SymbolB} PnL: ${totalPnlB:F2}");
+                Print($"   💰 Total PnL: ${totalPnl:F2}");
+            }
+
+            _hasPosition = false;
+            _stopLossSet = false;
+            // Reset trade type when positions are closed
+            _currentTradeType = TradeSide.Buy; // Default value, will be set on next entry
+        }
+
+        private bool IsSpreadAcceptable()
+        {
+            var spreadA = (_symbolAData.Ask - _symbolAData.Bid) / _symbolAData.PipSize;
+            var spreadB = (_symbolBData.Ask - _symbolBData.Bid) / _symbolBData.PipSize;
+
+            return spreadA <= _settings.MaxSpreadPips && spreadB <= _settings.MaxSpreadPips;
+        }
+
+        private void LogSignalData(double spread, double mean, double stdDev, double zScore)
+        {
+            if (_host.Now.Subtract(_lastLogTime).TotalSeconds >= 5)
+            {
+                Print($"📊 Spread: {spread:F6} | Mean: {mean:F6} | StdDev: {stdDev:F6} | Z-Score: {zScore:F4} | HasPos: {_hasPosition} | Equity: ${_host.Equity:F2}");
+                _lastLogTime = _host.Now;
+            }
+        }
+    }
+}
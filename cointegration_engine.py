@@ -0,0 +1,221 @@
+"""
+Cointegration Engine - Moment-based Engle-Granger tests over the aligned close matrix
+
+Every pair-level statistic of the Dickey-Fuller residual regression can be
+written as a quadratic form in a handful of N x N moment matrices (sums,
+Gram matrix and lag-1 cross products). Accumulating those once per sampling
+stride lets all N * (N - 1) ordered pairs be tested without building a
+residual series per pair.
+"""
+
+import math
+import numpy as np
+from typing import Dict, Sequence
+
+# Rows of the close matrix streamed per block; every stride consumes the
+# block while it is hot in cache
+BLOCK_ROWS = 8192
+
+# Engle-Granger with one regressor uses MacKinnon's tables for N = 2 series:
+# the (1994) p-value surface and (2010) critical values with a constant, as
+# in statsmodels.tsa.adfvalues. Kept here so the engine does not import
+# statsmodels (over a second of startup for the scan CLI).
+EG_TAU_MAX = 0.92
+EG_TAU_MIN = -18.86
+EG_TAU_STAR = -2.62
+EG_TAU_SMALLP = (2.92, 1.5012, 0.039796)
+EG_TAU_LARGEP = (2.1945, 0.64695, -0.29198, -0.042377)
+# 1%, 5%, 10% rows of c0 + c1 / T + c2 / T^2
+EG_CRIT_2010 = ((-3.89644, -10.9519, -33.527),
+                (-3.33613, -6.1101, -6.823),
+                (-3.04445, -4.2412, -2.72))
+
+
+def eg_pvalues(stats: np.ndarray) -> np.ndarray:
+    """
+    MacKinnon approximate p-values of Engle-Granger (N = 2, constant) statistics.
+
+    Matches statsmodels' mackinnonp(stat, 'c', N=2) element-wise.
+    """
+    stats = np.asarray(stats, dtype=float)
+    small = np.polyval(EG_TAU_SMALLP[::-1], stats)
+    large = np.polyval(EG_TAU_LARGEP[::-1], stats)
+    z = np.where(stats <= EG_TAU_STAR, small, large)
+    ncdf = np.frompyfunc(lambda v: 0.5 * math.erfc(-v / math.sqrt(2.0)), 1, 1)
+    p = ncdf(z).astype(float)
+    p = np.where(stats > EG_TAU_MAX, 1.0, p)
+    return np.where(stats < EG_TAU_MIN, 0.0, p)
+
+
+def eg_critical_values(nobs: int) -> np.ndarray:
+    """
+    MacKinnon (2010) 1%, 5%, 10% critical values for N = 2 at sample size nobs.
+    """
+    inv = 1.0 / nobs
+    return np.array([c0 + c1 * inv + c2 * inv * inv for c0, c1, c2 in EG_CRIT_2010])
+
+
+class StridedMoments:
+    """
+    Running moments of the sampled rows z_k = prices[offset + k * stride].
+    """
+
+    def __init__(self, num_symbols: int, stride: int):
+        self.stride = stride
+        self.count = 0
+        self.sum = np.zeros(num_symbols)
+        self.gram = np.zeros((num_symbols, num_symbols))
+        self.cross = np.zeros((num_symbols, num_symbols))  # sum z_k z_{k-1}^T
+        self.shift = np.zeros(num_symbols)                  # subtracted from every row
+        self.first = None
+        self.last = None
+
+    def update(self, rows: np.ndarray):
+        """
+        Accumulate a block of already-sampled rows.
+        """
+        if len(rows) == 0:
+            return
+
+        if self.first is None:
+            self.first = rows[0].copy()
+        else:
+            self.cross += np.outer(rows[0], self.last)
+
+        self.cross += rows[1:].T @ rows[:-1]
+        self.gram += rows.T @ rows
+        self.sum += rows.sum(axis=0)
+        self.count += len(rows)
+        self.last = rows[-1].copy()
+
+
+def accumulate_strided_moments(prices: np.ndarray, strides: Sequence[int],
+                               block_rows: int = BLOCK_ROWS) -> Dict[int, StridedMoments]:
+    """
+    Stream the close matrix once and accumulate moments for every stride.
+
+    Each block is visited once; strided views (no copies) select the rows
+    sampled at each frequency. Series are shifted by their first-block mean
+    so the raw moments stay well conditioned.
+
+    Args:
+        prices: (T x N) aligned close matrix
+        strides: Sampling strides in bars (1 = every bar)
+        block_rows: Rows per streamed block
+
+    Returns:
+        Mapping stride -> StridedMoments
+    """
+    num_rows, num_symbols = prices.shape
+    shift = prices[:min(block_rows, num_rows)].mean(axis=0)
+    moments = {stride: StridedMoments(num_symbols, stride) for stride in strides}
+    for acc in moments.values():
+        acc.shift = shift
+
+    for start in range(0, num_rows, block_rows):
+        block = prices[start:start + block_rows] - shift
+        for stride, acc in moments.items():
+            offset = (-start) % stride
+            acc.update(block[offset::stride])
+
+    return moments
+
+
+def engle_granger_from_moments(acc: StridedMoments) -> Dict[str, np.ndarray]:
+    """
+    Engle-Granger test for every ordered pair from one stride's moments.
+
+    Step 1 fits y = a + b * x by OLS for each (y, x) = (i, j). Step 2 runs the
+    Dickey-Fuller regression de(k) = rho * e(k-1) on the residuals, without a
+    constant as in statsmodels' coint(), with all residual sums obtained as
+    quadratic forms of the accumulated moments.
+
+    Note: this equals coint(y, x, maxlag=0, autolag=None); the default coint()
+    additionally selects augmentation lags by AIC.
+
+    Args:
+        acc: Moments for one sampling stride
+
+    Returns:
+        Dictionary of (N x N) arrays indexed [y, x]: 'hedge_ratio',
+        'intercept', 'r_squared', 'correlation', 'df_stat', 'p_value', plus
+        scalar 'n_obs' and the 'critical_values' (1%, 5%, 10%)
+    """
+    n = acc.count
+    m = n - 1
+    if m < 3:
+        raise ValueError(f"Not enough sampled observations ({n}) at stride {acc.stride}")
+
+    # Full-sample OLS of y (row) on x (column)
+    mean = acc.sum / n
+    cov = acc.gram / n - np.outer(mean, mean)
+    var = np.diag(cov)
+    with np.errstate(divide='ignore', invalid='ignore'):
+        beta = cov / var[None, :]                              # [y, x]
+        correlation = cov / np.sqrt(np.outer(var, var))
+    alpha = mean[:, None] - beta * mean[None, :]               # of the shifted series
+
+    # Moments of the lagged (k-1) and current (k) samples, k = 1..n-1
+    s_lag = acc.sum - acc.last
+    s_cur = acc.sum - acc.first
+    g_lag = acc.gram - np.outer(acc.last, acc.last)
+    g_cur = acc.gram - np.outer(acc.first, acc.first)
+    c_cl = acc.cross                                           # sum z_k z_{k-1}^T
+
+    def quad(g: np.ndarray, s_left: np.ndarray, s_right: np.ndarray) -> np.ndarray:
+        # sum_k e_left(k) * e_right(k) for e = y - beta * x - alpha, for all [y, x]
+        gyy = np.diag(g)[:, None]
+        gxx = np.diag(g)[None, :]
+        gyx = g
+        gxy = g.T
+        return (gyy - beta * gyx - beta * gxy + beta * beta * gxx
+                - alpha * (s_left[:, None] - beta * s_left[None, :])
+                - alpha * (s_right[:, None] - beta * s_right[None, :])
+                + m * alpha * alpha)
+
+    s_uu = quad(g_lag, s_lag, s_lag)
+    s_vv = quad(g_cur, s_cur, s_cur)
+    s_vu = quad(c_cl, s_cur, s_lag)
+
+    with np.errstate(divide='ignore', invalid='ignore'):
+        rho = (s_vu - s_uu) / s_uu
+        s_dd = s_vv - 2 * s_vu + s_uu
+        ssr = np.maximum(s_dd - rho * rho * s_uu, 0)
+        df_stat = rho / np.sqrt(ssr / (m - 1) / s_uu)
+
+    np.fill_diagonal(df_stat, np.nan)
+    p_value = np.full_like(df_stat, np.nan)
+    valid = np.isfinite(df_stat)
+    p_value[valid] = eg_pvalues(df_stat[valid])
+
+    # Residuals do not depend on the shift; the intercept of the raw series does
+    intercept = alpha + acc.shift[:, None] - beta * acc.shift[None, :]
+
+    return {
+        'hedge_ratio': beta,
+        'intercept': intercept,
+        'r_squared': correlation ** 2,
+        'correlation': correlation,
+        'df_stat': df_stat,
+        'p_value': p_value,
+        'n_obs': n,
+        'critical_values': eg_critical_values(m),
+    }
+
+
+def multi_frequency_cointegration(prices: np.ndarray, strides: Sequence[int] = (1, 5, 15, 60),
+                                  block_rows: int = BLOCK_ROWS) -> Dict[int, Dict[str, np.ndarray]]:
+    """
+    Engle-Granger tests for all pairs at several sampling frequencies in one call.
+
+    Args:
+        prices: (T x N) aligned close matrix
+        strides: Sampling strides in bars (1, 5, 15, 60 = 1m/5m/15m/1h on M1)
+        block_rows: Rows per streamed block
+
+    Returns:
+        Mapping stride -> result dictionary from engle_granger_from_moments
+    """
+    prices = np.asarray(prices, dtype=float)
+    moments = accumulate_strided_moments(prices, strides, block_rows)
+    return {stride: engle_granger_from_moments(acc) for stride, acc in moments.items()}
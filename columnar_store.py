@@ -0,0 +1,81 @@
+"""
+Columnar Store - Aligned close matrix on disk for headless scans
+
+A store is a directory holding the aligned universe as plain .npy columns:
+
+    close.npy        (T x N) float64 closes, memory-mapped on load
+    timestamps.npy   (T,) int64 nanoseconds since the epoch
+    symbols.json     column labels and the creation time
+
+Loading needs only numpy and json, so the scan CLI can start computing
+without importing pandas or the data client.
+"""
+
+import json
+import os
+import time
+import numpy as np
+from typing import Optional, Sequence, Tuple
+
+CLOSE_FILE = 'close.npy'
+TIMESTAMPS_FILE = 'timestamps.npy'
+SYMBOLS_FILE = 'symbols.json'
+
+NS_PER_DAY = 86_400 * 10**9
+
+
+def write_store(path: str, timestamps: np.ndarray, closes: np.ndarray, symbols: Sequence[str]):
+    """
+    Write an aligned close matrix as a columnar store.
+
+    Args:
+        path: Store directory (created if missing)
+        timestamps: (T,) datetime64 or int64 nanosecond timestamps
+        closes: (T x N) close matrix
+        symbols: Column labels
+    """
+    closes = np.ascontiguousarray(closes, dtype=np.float64)
+    if closes.shape != (len(timestamps), len(symbols)):
+        raise ValueError(f"Close matrix {closes.shape} does not match "
+                         f"{len(timestamps)} timestamps x {len(symbols)} symbols")
+
+    os.makedirs(path, exist_ok=True)
+    np.save(os.path.join(path, CLOSE_FILE), closes)
+    np.save(os.path.join(path, TIMESTAMPS_FILE),
+            np.asarray(timestamps).astype('datetime64[ns]').view(np.int64))
+    with open(os.path.join(path, SYMBOLS_FILE), 'w') as f:
+        json.dump({'symbols': list(symbols), 'created': time.time()}, f)
+
+
+def load_store(path: str, symbols: Optional[Sequence[str]] = None,
+               lookback_days: Optional[float] = None,
+               mmap_mode: Optional[str] = 'r') -> Tuple[np.ndarray, np.ndarray, list]:
+    """
+    Load a columnar store, optionally restricted to symbols and a trailing window.
+
+    Args:
+        path: Store directory
+        symbols: Columns to keep, in this order (missing ones are skipped)
+        lookback_days: Keep only bars within this many days of the last bar
+        mmap_mode: Passed to np.load; 'r' maps the closes instead of reading them
+
+    Returns:
+        Tuple of ((T,) int64 timestamps, (T x K) closes, K symbols)
+    """
+    with open(os.path.join(path, SYMBOLS_FILE)) as f:
+        stored = json.load(f)['symbols']
+    closes = np.load(os.path.join(path, CLOSE_FILE), mmap_mode=mmap_mode)
+    timestamps = np.load(os.path.join(path, TIMESTAMPS_FILE))
+
+    start = 0
+    if lookback_days is not None and len(timestamps):
+        start = int(np.searchsorted(timestamps, timestamps[-1] - int(lookback_days * NS_PER_DAY)))
+
+    if symbols is None:
+        return timestamps[start:], closes[start:], list(stored)
+
+    position = {s: k for k, s in enumerate(stored)}
+    kept = [s for s in symbols if s in position]
+    columns = [position[s] for s in kept]
+    # One gather over the trailing rows; the rest of the mapping is never read
+    return timestamps[start:], np.asarray(closes[start:][:, columns]), kept
@@ -0,0 +1,101 @@
+"""
+Correlation Engine - Tiled Pearson correlation into packed pair storage
+
+Columns are standardized once; the correlation matrix is then produced one
+(row block x column block) tile at a time on or above the diagonal and
+written straight into a PairMatrix and/or a sparse thresholded graph, so the
+dense N x N matrix is never built.
+"""
+
+import numpy as np
+from typing import Iterator, Optional, Sequence, Tuple
+
+from pair_matrix import PairMatrix
+from correlation_graph import CorrelationGraph
+
+DEFAULT_TILE_SIZE = 256
+
+
+def standardize_columns(values: np.ndarray) -> np.ndarray:
+    """
+    Center each column and scale it to unit norm, so Z^T Z is the correlation.
+    """
+    centered = values - values.mean(axis=0)
+    norms = np.sqrt(np.einsum('ij,ij->j', centered, centered))
+    norms[norms == 0] = np.nan
+    return centered / norms
+
+
+def correlation_tiles(values: np.ndarray, tile_size: int = DEFAULT_TILE_SIZE
+                      ) -> Iterator[Tuple[slice, slice, np.ndarray]]:
+    """
+    Yield (rows, cols, block) correlation tiles on or above the diagonal.
+    """
+    z = standardize_columns(np.asarray(values, dtype=float))
+    n = z.shape[1]
+    for row_start in range(0, n, tile_size):
+        rows = slice(row_start, min(row_start + tile_size, n))
+        for col_start in range(row_start, n, tile_size):
+            cols = slice(col_start, min(col_start + tile_size, n))
+            yield rows, cols, z[:, rows].T @ z[:, cols]
+
+
+def scan_correlations(values: np.ndarray, symbols: Sequence[str],
+                      tile_size: int = DEFAULT_TILE_SIZE, keep_matrix: bool = True,
+                      graph_threshold: Optional[float] = None
+                      ) -> Tuple[Optional[PairMatrix], Optional[CorrelationGraph]]:
+    """
+    Single tiled pass producing the packed matrix and/or the sparse graph.
+
+    Args:
+        values: (T x N) aligned price matrix
+        symbols: Column labels
+        tile_size: Symbols per tile edge
+        keep_matrix: Store every correlation in a PairMatrix
+        graph_threshold: If set, emit edges with |correlation| >= threshold
+
+    Returns:
+        Tuple of (PairMatrix or None, CorrelationGraph or None)
+    """
+    matrix = PairMatrix(symbols, diagonal=True) if keep_matrix else None
+    edge_rows, edge_cols, edge_weights = [], [], []
+
+    for rows, cols, block in correlation_tiles(values, tile_size):
+        if matrix is not None:
+            matrix.set_tile(rows, cols, block)
+
+        if graph_threshold is not None:
+            local_i, local_j = np.nonzero(np.abs(block) >= graph_threshold)
+            i = local_i + rows.start
+            j = local_j + cols.start
+            upper = i < j
+            edge_rows.append(i[upper])
+            edge_cols.append(j[upper])
+            edge_weights.append(block[local_i[upper], local_j[upper]])
+
+    graph = None
+    if graph_threshold is not None:
+        concat = lambda parts, dtype: np.concatenate(parts) if parts else np.empty(0, dtype=dtype)
+        graph = CorrelationGraph.from_edges(
+            symbols, concat(edge_rows, int), concat(edge_cols, int),
+            concat(edge_weights, float), graph_threshold
+        )
+
+    return matrix, graph
+
+
+def tiled_correlation(values: np.ndarray, symbols: Sequence[str],
+                      tile_size: int = DEFAULT_TILE_SIZE) -> PairMatrix:
+    """
+    Pearson correlation of all columns, computed tile by tile.
+
+    Args:
+        values: (T x N) aligned price matrix
+        symbols: Column labels
+        tile_size: Symbols per tile edge
+
+    Returns:
+        PairMatrix (with diagonal) of correlations
+    """
+    matrix, _ = scan_correlations(values, symbols, tile_size)
+    return matrix
@@ -0,0 +1,119 @@
+"""
+Correlation Graph - Sparse thresholded correlation graph and basket discovery
+
+The graph keeps only edges with |correlation| >= threshold, in CSR form.
+Connected components and maximal cliques of that graph are natural
+candidates for multivariate (basket) cointegration.
+"""
+
+import os
+import numpy as np
+from concurrent.futures import ProcessPoolExecutor
+from typing import Dict, FrozenSet, List, Optional, Sequence
+
+# Below this many edges in total, cliques are enumerated in-process
+# (process start-up would dominate the search)
+PARALLEL_MIN_EDGES = 5000
+
+
+def _bron_kerbosch(adjacency: Dict[int, FrozenSet[int]], min_size: int) -> List[List[int]]:
+    """
+    Maximal cliques of one component (Bron-Kerbosch with Tomita pivoting).
+
+    Iterative so deep recursion on dense components cannot overflow the stack.
+    """
+    cliques = []
+    stack = [(set(), set(adjacency), set())]
+
+    while stack:
+        clique, candidates, excluded = stack.pop()
+        if not candidates and not excluded:
+            if len(clique) >= min_size:
+                cliques.append(sorted(clique))
+            continue
+        if len(clique) + len(candidates) < min_size:
+            continue
+
+        pivot = max(candidates | excluded, key=lambda u: len(adjacency[u] & candidates))
+        for v in list(candidates - adjacency[pivot]):
+            neighbours = adjacency[v]
+            stack.append((clique | {v}, candidates & neighbours, excluded & neighbours))
+            candidates.remove(v)
+            excluded.add(v)
+
+    return cliques
+
+
+class CorrelationGraph:
+    """
+    Sparse, symmetric graph of strongly correlated symbols.
+    """
+
+    def __init__(self, symbols: Sequence[str], graph: 'csr_matrix', threshold: float):
+        self.symbols = list(symbols)
+        self.graph = graph
+        self.threshold = threshold
+
+    @classmethod
+    def from_edges(cls, symbols: Sequence[str], rows: np.ndarray, cols: np.ndarray,
+                   weights: np.ndarray, threshold: float) -> 'CorrelationGraph':
+        """
+        Build the symmetric CSR graph from upper-triangular edges (i < j).
+        """
+        from scipy.sparse import csr_matrix   # deferred: scipy.sparse is slow to import
+        n = len(symbols)
+        both_rows = np.concatenate([rows, cols])
+        both_cols = np.concatenate([cols, rows])
+        both_weights = np.concatenate([weights, weights])
+        graph = csr_matrix((both_weights, (both_rows, both_cols)), shape=(n, n))
+        return cls(symbols, graph, threshold)
+
+    @property
+    def num_edges(self) -> int:
+        return self.graph.nnz // 2
+
+    def neighbours(self, i: int) -> np.ndarray:
+        return self.graph.indices[self.graph.indptr[i]:self.graph.indptr[i + 1]]
+
+    def components(self, min_size: int = 2) -> List[List[int]]:
+        """
+        Connected components with at least `min_size` symbols, largest first.
+        """
+        from scipy.sparse.csgraph import connected_components
+        _, labels = connected_components(self.graph, directed=False)
+        groups = {}
+        for i, label in enumerate(labels):
+            groups.setdefault(label, []).append(i)
+        found = [members for members in groups.values() if len(members) >= min_size]
+        return sorted(found, key=len, reverse=True)
+
+    def maximal_cliques(self, min_size: int = 3, max_workers: Optional[int] = None) -> List[List[int]]:
+        """
+        Maximal cliques with at least `min_size` symbols, largest first.
+
+        Cliques never span components, so each component is searched
+        independently; large graphs fan the components out to a process pool.
+        """
+        adjacencies = []
+        for members in self.components(min_size=min_size):
+            adjacencies.append({i: frozenset(self.neighbours(i).tolist()) for i in members})
+
+        workers = max_workers or os.cpu_count() or 1
+        if workers > 1 and len(adjacencies) > 1 and self.num_edges >= PARALLEL_MIN_EDGES:
+            with ProcessPoolExecutor(max_workers=min(workers, len(adjacencies))) as pool:
+                parts = list(pool.map(_bron_kerbosch, adjacencies, [min_size] * len(adjacencies)))
+        else:
+            parts = [_bron_kerbosch(adjacency, min_size) for adjacency in adjacencies]
+
+        cliques = [clique for part in parts for clique in part]
+        return sorted(cliques, key=len, reverse=True)
+
+    def mean_abs_correlation(self, members: Sequence[int]) -> float:
+        """
+        Mean |correlation| over the graph edges inside a group of symbols.
+        """
+        sub = self.graph[members][:, members]
+        return float(np.abs(sub.data).mean()) if sub.nnz else 0.0
+
+    def names(self, members: Sequence[int]) -> List[str]:
+        return [self.symbols[i] for i in members]
@@ -0,0 +1,140 @@
+"""
+Currency Factors - Per-bar currency strengths from quoted FX pairs
+
+Every FX quote is a difference of two currency log-strengths:
+
+    log p_{AB}(t) = s_A(t) - s_B(t)
+
+Stacking the quoted symbols gives an incidence matrix M (symbols x
+currencies, +1 for the base and -1 for the quote), and the strengths at every
+bar are the least-squares solution of M s(t) = log p(t). The system is only
+determined up to a common shift; the pseudo-inverse picks the solution with
+zero mean across currencies, and all bars are solved with one matrix
+product.
+
+Screening then happens among the ~10 currencies instead of the O(N^2)
+symbol pairs: currency pairs whose strengths are cointegrated are mapped
+back to the symbol pairs whose spread isolates them (XZ vs YZ share Z, so
+log XZ - log YZ = s_X - s_Y).
+"""
+
+import numpy as np
+from itertools import combinations
+from typing import Dict, List, Sequence, Tuple
+
+from cointegration_engine import multi_frequency_cointegration
+from fx_triangles import split_fx_symbol
+
+
+def currency_incidence(symbols: Sequence[str]) -> Tuple[List[str], np.ndarray, np.ndarray]:
+    """
+    Incidence matrix of the FX symbols in a universe.
+
+    Args:
+        symbols: Universe symbols (non-FX symbols are skipped)
+
+    Returns:
+        Tuple of (currencies, (F x C) incidence matrix, (F,) column indices
+        of the FX symbols in `symbols`)
+    """
+    fx_columns, legs = [], []
+    for i, symbol in enumerate(symbols):
+        parsed = split_fx_symbol(symbol)
+        if parsed is not None:
+            fx_columns.append(i)
+            legs.append(parsed)
+
+    currencies = sorted({c for leg in legs for c in leg})
+    position = {c: k for k, c in enumerate(currencies)}
+    incidence = np.zeros((len(legs), len(currencies)))
+    for row, (base, quote) in enumerate(legs):
+        incidence[row, position[base]] = 1.0
+        incidence[row, position[quote]] = -1.0
+
+    return currencies, incidence, np.array(fx_columns, dtype=int)
+
+
+def currency_strengths(log_prices: np.ndarray, incidence: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Least-squares currency log-strengths for every bar.
+
+    Args:
+        log_prices: (T x F) log closes of the FX symbols
+        incidence: (F x C) incidence matrix
+
+    Returns:
+        Tuple of ((T x C) strengths with zero cross-currency mean, (T x F)
+        residuals; non-zero residuals are quotes inconsistent with the rest,
+        i.e. triangular mispricing)
+    """
+    solve = np.linalg.pinv(incidence)                    # (C x F)
+    strengths = log_prices @ solve.T
+    residuals = log_prices - strengths @ incidence.T
+    return strengths, residuals
+
+
+def implied_correlation(strengths: np.ndarray, incidence: np.ndarray) -> np.ndarray:
+    """
+    Symbol-level return correlation implied by the currency covariance.
+
+    cov(r_i, r_j) = m_i^T Sigma m_j, so the full F x F matrix comes from the
+    C x C covariance of strength returns.
+    """
+    sigma = np.cov(np.diff(strengths, axis=0), rowvar=False)
+    cov = incidence @ sigma @ incidence.T
+    std = np.sqrt(np.diag(cov))
+    with np.errstate(divide='ignore', invalid='ignore'):
+        return cov / np.outer(std, std)
+
+
+def cointegrated_currency_pairs(strengths: np.ndarray, currencies: Sequence[str],
+                                significance_level: float = 0.05) -> List[Dict]:
+    """
+    Engle-Granger screen of all currency-strength pairs.
+
+    Uses the moment-based (zero-lag) test of cointegration_engine; each
+    unordered pair is reported with the smaller p-value of its two orderings.
+
+    Returns:
+        List of dictionaries with 'currency1', 'currency2', 'p_value',
+        'hedge_ratio', sorted by p-value
+    """
+    stats = multi_frequency_cointegration(strengths, strides=(1,))[1]
+    p_values, hedge = stats['p_value'], stats['hedge_ratio']
+
+    pairs = []
+    for i, j in combinations(range(len(currencies)), 2):
+        y, x = (i, j) if p_values[i, j] <= p_values[j, i] else (j, i)
+        if p_values[y, x] < significance_level:
+            pairs.append({
+                'currency1': currencies[y],
+                'currency2': currencies[x],
+                'p_value': p_values[y, x],
+                'hedge_ratio': hedge[y, x],
+            })
+    return sorted(pairs, key=lambda r: r['p_value'])
+
+
+def map_to_symbol_pairs(symbols: Sequence[str], currency_pairs: List[Dict]) -> List[Tuple[str, str]]:
+    """
+    Symbol pairs whose spread isolates a cointegrated currency pair.
+
+    For currencies X and Y these are the symbols that quote X and Y against
+    the same third currency Z (XZ/YZ, ZX/ZY, XZ/ZY, ...), in universe order.
+    """
+    legs = {}
+    for symbol in symbols:
+        parsed = split_fx_symbol(symbol)
+        if parsed is not None:
+            legs[symbol] = parsed
+
+    wanted = {frozenset((p['currency1'], p['currency2'])) for p in currency_pairs}
+    candidates = []
+    for symbol1, symbol2 in combinations(legs, 2):
+        a, b = set(legs[symbol1]), set(legs[symbol2])
+        shared = a & b
+        if len(shared) != 1:
+            continue
+        if frozenset((a - shared) | (b - shared)) in wanted:
+            candidates.append((symbol1, symbol2))
+    return candidates
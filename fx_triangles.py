@@ -0,0 +1,263 @@
+"""
+FX Triangles - Synthetic crosses and triangular mispricing for FX universes
+
+A quoted cross is redundant with two legs through a common currency:
+EURCHF ~ EURUSD * USDCHF, EURGBP ~ EURUSD / GBPUSD. In log space every FX
+symbol BASEQUOTE is an edge log(BASE/QUOTE), so a synthetic cross is a signed
+sum of two leg columns and the mispricing is one more signed column:
+
+    mispricing = log(cross) - (s1 * log(leg1) + s2 * log(leg2))
+
+Batch mode evaluates every triangle over the aligned close matrix with one
+gather per leg. Live mode (TriangleMonitor) keeps the latest log mid per
+symbol and updates only the triangles that contain the ticking symbol, each
+in O(1), with exponentially weighted mean/variance for z-scores.
+"""
+
+import numpy as np
+from typing import Dict, List, Optional, Sequence, Tuple
+
+# Mispricing is reported in basis points of the cross price
+BPS = 1e4
+
+# Half-life (in updates) of the live monitor's mean/variance
+DEFAULT_EWMA_HALF_LIFE = 500
+
+# Updates per triangle before the live monitor reports z-scores
+DEFAULT_WARMUP = 100
+
+# Currency the majors are quoted against; a triangle's cross is the symbol without it
+VEHICLE_CURRENCY = 'USD'
+
+
+def split_fx_symbol(symbol: str) -> Optional[Tuple[str, str]]:
+    """
+    (base, quote) of a 6-letter FX symbol such as 'EURUSD', else None.
+    """
+    if len(symbol) != 6 or not symbol.isalpha() or not symbol.isupper():
+        return None
+    return symbol[:3], symbol[3:]
+
+
+def find_triangles(symbols: Sequence[str]) -> List[Dict]:
+    """
+    Every (cross, leg1, leg2) triangle that can be formed from the symbols.
+
+    For each symbol A/B and each third currency X, the legs A/X and X/B are
+    looked up in either quoting direction (a leg quoted X/A enters with
+    sign -1).
+
+    Args:
+        symbols: Available symbols (non-FX symbols are ignored)
+
+    Returns:
+        List of dictionaries with 'cross', 'via', 'leg1', 'leg2' symbol names,
+        their column indices 'ic', 'i1', 'i2' and leg signs 's1', 's2'
+    """
+    edges = {}
+    for i, symbol in enumerate(symbols):
+        parsed = split_fx_symbol(symbol)
+        if parsed is None:
+            continue
+        base, quote = parsed
+        edges[(base, quote)] = (i, 1.0)
+        edges.setdefault((quote, base), (i, -1.0))
+
+    currencies = sorted({c for pair in edges for c in pair})
+    triangles = []
+    for ic, symbol in enumerate(symbols):
+        parsed = split_fx_symbol(symbol)
+        if parsed is None:
+            continue
+        base, quote = parsed
+        for via in currencies:
+            if via in (base, quote):
+                continue
+            leg1 = edges.get((base, via))
+            leg2 = edges.get((via, quote))
+            if leg1 is None or leg2 is None:
+                continue
+            (i1, s1), (i2, s2) = leg1, leg2
+            triangles.append({
+                'cross': symbol, 'via': via,
+                'leg1': symbols[i1], 'leg2': symbols[i2],
+                'ic': ic, 'i1': i1, 'i2': i2, 's1': s1, 's2': s2,
+            })
+    return triangles
+
+
+def _dedupe(triangles: List[Dict]) -> List[Dict]:
+    # The same three symbols form one triangle whichever is called the cross;
+    # keep the orientation whose cross avoids the vehicle currency (EURCHF
+    # against EURUSD and USDCHF), else the first one found
+    chosen = {}
+    for tri in triangles:
+        key = frozenset((tri['ic'], tri['i1'], tri['i2']))
+        is_cross = VEHICLE_CURRENCY not in split_fx_symbol(tri['cross'])
+        if key not in chosen or (is_cross and VEHICLE_CURRENCY in split_fx_symbol(chosen[key]['cross'])):
+            chosen[key] = tri
+    return list(chosen.values())
+
+
+def synthetic_crosses(log_prices: np.ndarray, triangles: List[Dict]) -> np.ndarray:
+    """
+    Synthetic log cross of every triangle from its two legs.
+
+    Args:
+        log_prices: (T x N) log close matrix
+        triangles: Output of find_triangles
+
+    Returns:
+        (T x K) synthetic log prices
+    """
+    i1 = np.array([t['i1'] for t in triangles], dtype=int)
+    i2 = np.array([t['i2'] for t in triangles], dtype=int)
+    s1 = np.array([t['s1'] for t in triangles])
+    s2 = np.array([t['s2'] for t in triangles])
+    return log_prices[:, i1] * s1 + log_prices[:, i2] * s2
+
+
+def triangle_mispricing(prices: np.ndarray, symbols: Sequence[str],
+                        unique: bool = True) -> Tuple[List[Dict], np.ndarray]:
+    """
+    Mispricing of every quoted cross against its synthetic, for all bars.
+
+    Args:
+        prices: (T x N) aligned close matrix
+        symbols: Column labels
+        unique: Report each set of three symbols once
+
+    Returns:
+        Tuple of (triangles, (T x K) mispricing in basis points); the
+        triangle dictionaries gain 'mean_bps', 'std_bps', 'max_abs_bps' and
+        'last_z'
+    """
+    triangles = find_triangles(symbols)
+    if unique:
+        triangles = _dedupe(triangles)
+    if not triangles:
+        return [], np.empty((len(prices), 0))
+
+    log_prices = np.log(prices)
+    ic = np.array([t['ic'] for t in triangles], dtype=int)
+    mispricing = (log_prices[:, ic] - synthetic_crosses(log_prices, triangles)) * BPS
+
+    mean = mispricing.mean(axis=0)
+    std = mispricing.std(axis=0)
+    max_abs = np.abs(mispricing).max(axis=0)
+    with np.errstate(divide='ignore', invalid='ignore'):
+        last_z = (mispricing[-1] - mean) / std
+
+    for k, tri in enumerate(triangles):
+        tri['mean_bps'] = mean[k]
+        tri['std_bps'] = std[k]
+        tri['max_abs_bps'] = max_abs[k]
+        tri['last_z'] = last_z[k]
+
+    return triangles, mispricing
+
+
+class TriangleMonitor:
+    """
+    Live triangular mispricing with O(1) work per affected triangle per tick.
+    """
+
+    def __init__(self, symbols: Sequence[str], ewma_half_life: float = DEFAULT_EWMA_HALF_LIFE,
+                 entry_z: float = 3.0, warmup: int = DEFAULT_WARMUP):
+        """
+        Args:
+            symbols: Symbols that will tick
+            ewma_half_life: Half-life, in updates, of each triangle's mean/variance
+            entry_z: |z| at which on_tick reports a triangle
+            warmup: Updates per triangle before it can be reported
+        """
+        self.symbols = list(symbols)
+        self.warmup = warmup
+        self._column = {symbol: i for i, symbol in enumerate(self.symbols)}
+        self.triangles = _dedupe(find_triangles(self.symbols))
+        self.entry_z = entry_z
+        self._decay = 0.5 ** (1.0 / ewma_half_life)
+
+        k = len(self.triangles)
+        self._ic = np.array([t['ic'] for t in self.triangles], dtype=int)
+        self._i1 = np.array([t['i1'] for t in self.triangles], dtype=int)
+        self._i2 = np.array([t['i2'] for t in self.triangles], dtype=int)
+        self._s1 = np.array([t['s1'] for t in self.triangles])
+        self._s2 = np.array([t['s2'] for t in self.triangles])
+
+        self.log_mid = np.full(len(self.symbols), np.nan)
+        self.mispricing = np.full(k, np.nan)
+        self.mean = np.zeros(k)
+        self.var = np.zeros(k)
+        self.updates = np.zeros(k, dtype=np.int64)
+
+        # Symbol -> triangles it belongs to
+        members = [[] for _ in self.symbols]
+        for t in range(k):
+            for i in (self._ic[t], self._i1[t], self._i2[t]):
+                members[i].append(t)
+        self._members = [np.array(m, dtype=int) for m in members]
+
+    def on_tick(self, symbol: str, bid: float, ask: float) -> List[Dict]:
+        """
+        Update one symbol's mid and the triangles that contain it.
+
+        Args:
+            symbol: Ticking symbol
+            bid: Bid price
+            ask: Ask price
+
+        Returns:
+            Triangles whose |z| reached entry_z on this tick, with 'z' and
+            'mispricing_bps' (cross rich vs. synthetic when positive)
+        """
+        i = self._column.get(symbol)
+        if i is None:
+            return []
+        self.log_mid[i] = np.log(0.5 * (bid + ask))
+
+        tri = self._members[i]
+        if len(tri) == 0:
+            return []
+
+        value = (self.log_mid[self._ic[tri]]
+                 - self.log_mid[self._i1[tri]] * self._s1[tri]
+                 - self.log_mid[self._i2[tri]] * self._s2[tri]) * BPS
+        ready = np.isfinite(value)
+        tri, value = tri[ready], value[ready]
+        if len(tri) == 0:
+            return []
+
+        # Exponentially weighted mean/variance, seeded by the first value
+        first = self.updates[tri] == 0
+        delta = value - self.mean[tri]
+        mean = np.where(first, value, self.mean[tri] + (1 - self._decay) * delta)
+        var = np.where(first, 0.0, self._decay * (self.var[tri] + (1 - self._decay) * delta * delta))
+        self.mean[tri] = mean
+        self.var[tri] = var
+        self.mispricing[tri] = value
+        self.updates[tri] += 1
+
+        with np.errstate(divide='ignore', invalid='ignore'):
+            z = (value - mean) / np.sqrt(var)
+        signals = []
+        for t, zt, v in zip(tri, z, value):
+            if self.updates[t] >= self.warmup and np.isfinite(zt) and abs(zt) >= self.entry_z:
+                triangle = self.triangles[t]
+                signals.append({
+                    'cross': triangle['cross'], 'leg1': triangle['leg1'], 'leg2': triangle['leg2'],
+                    'z': zt, 'mispricing_bps': v,
+                })
+        return signals
+
+    def snapshot(self) -> List[Dict]:
+        """
+        Current mispricing and z-score of every triangle.
+        """
+        with np.errstate(divide='ignore', invalid='ignore'):
+            z = (self.mispricing - self.mean) / np.sqrt(self.var)
+        return [
+            {'cross': t['cross'], 'leg1': t['leg1'], 'leg2': t['leg2'],
+             'mispricing_bps': self.mispricing[k], 'z': z[k], 'updates': int(self.updates[k])}
+            for k, t in enumerate(self.triangles)
+        ]
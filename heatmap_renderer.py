@@ -0,0 +1,258 @@
+"""
+Heatmap Renderer - Clustered correlation heatmaps rasterized straight to PNG
+
+For large universes the seaborn heatmap (one annotated artist per cell) is
+too slow and needs a display. This renderer:
+
+- reorders symbols by average-linkage hierarchical clustering so correlated
+  blocks sit on the diagonal
+- maps each cell through a 256-entry color lookup table (RdYlBu_r) with
+  numpy, one pixel (or a small square) per cell, block-averaging when the
+  matrix is larger than the requested image
+- writes PNGs with zlib directly, without matplotlib
+- for very large N, writes a zoom pyramid of 256 x 256 tiles
+  (<dir>/<level>/<row>_<col>.png, level 0 coarsest) plus a JSON index with
+  the symbol order, for a tile viewer
+
+Matrices can be dense arrays or packed PairMatrix instances. A PairMatrix is
+never expanded: clustering works on its packed upper triangle and the
+renderers read one reordered tile at a time.
+"""
+
+import json
+import os
+import struct
+import zlib
+import numpy as np
+from scipy.cluster.hierarchy import leaves_list, linkage
+from scipy.spatial.distance import squareform
+from typing import Callable, Dict, Optional, Sequence, Union
+
+from pair_matrix import PairMatrix
+
+Matrix = Union[np.ndarray, PairMatrix]
+
+# ColorBrewer RdYlBu, reversed so -1 is blue and +1 is red (seaborn's 'RdYlBu_r')
+RDYLBU_R = [
+    '#313695', '#4575b4', '#74add1', '#abd9e9', '#e0f3f8', '#ffffbf',
+    '#fee090', '#fdae61', '#f46d43', '#d73027', '#a50026',
+]
+NAN_COLOR = (200, 200, 200)
+
+TILE_SIZE = 256
+
+# zlib level: 1 is several times faster than the default for a few % larger files
+PNG_COMPRESSION = 1
+
+
+def color_lut(anchors: Sequence[str] = RDYLBU_R, size: int = 256) -> np.ndarray:
+    """
+    (size x 3) uint8 lookup table interpolated between hex anchor colors.
+    """
+    rgb = np.array([[int(c[i:i + 2], 16) for i in (1, 3, 5)] for c in anchors], dtype=float)
+    positions = np.linspace(0, 1, len(anchors))
+    grid = np.linspace(0, 1, size)
+    lut = np.column_stack([np.interp(grid, positions, rgb[:, k]) for k in range(3)])
+    return np.round(lut).astype(np.uint8)
+
+
+def cluster_order(matrix: Matrix) -> np.ndarray:
+    """
+    Leaf order of an average-linkage clustering on 1 - correlation.
+
+    For a PairMatrix the condensed distances come straight from the packed
+    upper triangle, which is already in scipy's condensed order.
+    """
+    if isinstance(matrix, PairMatrix):
+        n = matrix.n
+        if n < 3:
+            return np.arange(n)
+        values = matrix.data
+        if matrix.diagonal:
+            rows = np.arange(n)
+            values = np.delete(values, rows * n - rows * (rows - 1) // 2)
+        condensed = np.clip(1.0 - np.nan_to_num(values, nan=0.0), 0.0, 2.0)
+        return leaves_list(linkage(condensed, method='average'))
+
+    n = matrix.shape[0]
+    if n < 3:
+        return np.arange(n)
+    distance = 1.0 - np.nan_to_num(matrix, nan=0.0)
+    distance = (distance + distance.T) / 2
+    np.fill_diagonal(distance, 0.0)
+    condensed = squareform(np.clip(distance, 0.0, 2.0), checks=False)
+    return leaves_list(linkage(condensed, method='average'))
+
+
+def block_reader(matrix: Matrix, order: Optional[np.ndarray] = None) -> Callable[[int, int, int, int], np.ndarray]:
+    """
+    Reader of dense blocks [r0:r1, c0:c1] of the matrix with rows and columns
+    permuted by `order` (identity if None).
+    """
+    n = matrix.n if isinstance(matrix, PairMatrix) else matrix.shape[0]
+    ids = np.arange(n) if order is None else np.asarray(order)
+
+    def read(r0: int, r1: int, c0: int, c1: int) -> np.ndarray:
+        if isinstance(matrix, PairMatrix):
+            return matrix.take(ids[r0:r1], ids[c0:c1])
+        if order is None:
+            return matrix[r0:r1, c0:c1]
+        return matrix[np.ix_(ids[r0:r1], ids[c0:c1])]
+
+    return read
+
+
+def block_mean(matrix: np.ndarray, factor: int) -> np.ndarray:
+    """
+    Downsample by averaging factor x factor blocks (NaN-aware, edges padded).
+    """
+    if factor <= 1:
+        return matrix
+    n_rows, n_cols = matrix.shape
+    pad_rows = -n_rows % factor
+    pad_cols = -n_cols % factor
+    padded = np.pad(matrix, ((0, pad_rows), (0, pad_cols)), constant_values=np.nan)
+    blocks = padded.reshape(padded.shape[0] // factor, factor, padded.shape[1] // factor, factor)
+    with np.errstate(invalid='ignore'):
+        total = np.nansum(blocks, axis=(1, 3))
+        count = np.sum(~np.isnan(blocks), axis=(1, 3))
+        return np.where(count > 0, total / np.maximum(count, 1), np.nan)
+
+
+def colorize(matrix: np.ndarray, lut: np.ndarray, vmin: float = -1.0, vmax: float = 1.0) -> np.ndarray:
+    """
+    Map values to an (H x W x 3) uint8 image through the lookup table.
+    """
+    scaled = (np.nan_to_num(matrix, nan=vmin) - vmin) / (vmax - vmin)
+    index = np.clip((scaled * (len(lut) - 1)).round(), 0, len(lut) - 1).astype(np.intp)
+    image = lut[index]
+    image[np.isnan(matrix)] = NAN_COLOR
+    return image
+
+
+def write_png(path: str, image: np.ndarray, compression: int = PNG_COMPRESSION):
+    """
+    Write an (H x W x 3) uint8 RGB image as a PNG (no filtering).
+    """
+    height, width, _ = image.shape
+    rows = np.empty((height, 1 + width * 3), dtype=np.uint8)
+    rows[:, 0] = 0                                   # filter type None per scanline
+    rows[:, 1:] = image.reshape(height, width * 3)
+
+    def chunk(tag: bytes, data: bytes) -> bytes:
+        return (struct.pack('>I', len(data)) + tag + data
+                + struct.pack('>I', zlib.crc32(tag + data) & 0xffffffff))
+
+    header = struct.pack('>IIBBBBB', width, height, 8, 2, 0, 0, 0)
+    with open(path, 'wb') as f:
+        f.write(b'\x89PNG\r\n\x1a\n')
+        f.write(chunk(b'IHDR', header))
+        f.write(chunk(b'IDAT', zlib.compress(rows.tobytes(), compression)))
+        f.write(chunk(b'IEND', b''))
+
+
+def render_heatmap(matrix: Matrix, path: str, max_pixels: int = 4096,
+                   cell_pixels: Optional[int] = None, vmin: float = -1.0,
+                   vmax: float = 1.0, order: Optional[np.ndarray] = None) -> Dict:
+    """
+    Render a matrix, with rows and columns permuted by `order`, to a single PNG.
+
+    Small matrices get square cells of `cell_pixels` (default: as large as
+    fits in max_pixels, capped at 16); large ones are block-averaged down
+    to at most max_pixels per side. The image is filled tile by tile, so
+    only the image and one tile of values are in memory.
+
+    Returns:
+        Dictionary with 'path', 'pixels' and 'cells_per_pixel'/'pixels_per_cell'
+    """
+    n = matrix.n if isinstance(matrix, PairMatrix) else matrix.shape[0]
+    read = block_reader(matrix, order)
+    lut = color_lut()
+    if n <= max_pixels:
+        scale = cell_pixels or max(1, min(16, max_pixels // max(n, 1)))
+        image = np.empty((n * scale, n * scale, 3), dtype=np.uint8)
+        for r0 in range(0, n, TILE_SIZE):
+            r1 = min(r0 + TILE_SIZE, n)
+            for c0 in range(0, n, TILE_SIZE):
+                c1 = min(c0 + TILE_SIZE, n)
+                tile = colorize(read(r0, r1, c0, c1), lut, vmin, vmax)
+                if scale > 1:
+                    tile = np.repeat(np.repeat(tile, scale, axis=0), scale, axis=1)
+                image[r0 * scale:r1 * scale, c0 * scale:c1 * scale] = tile
+        write_png(path, image)
+        return {'path': path, 'pixels': image.shape[0], 'pixels_per_cell': scale}
+
+    # Tiles span whole factor x factor blocks, so averaging them separately
+    # equals averaging the full matrix
+    factor = -(-n // max_pixels)
+    size = -(-n // factor)
+    step = max(1, TILE_SIZE // factor)
+    image = np.empty((size, size, 3), dtype=np.uint8)
+    for p0 in range(0, size, step):
+        r0, r1 = p0 * factor, min((p0 + step) * factor, n)
+        for q0 in range(0, size, step):
+            c0, c1 = q0 * factor, min((q0 + step) * factor, n)
+            block = block_mean(read(r0, r1, c0, c1), factor)
+            image[p0:p0 + block.shape[0], q0:q0 + block.shape[1]] = colorize(block, lut, vmin, vmax)
+    write_png(path, image)
+    return {'path': path, 'pixels': image.shape[0], 'cells_per_pixel': factor}
+
+
+def render_pyramid(matrix: Matrix, out_dir: str, symbols: Sequence[str],
+                   tile_size: int = TILE_SIZE, vmin: float = -1.0, vmax: float = 1.0,
+                   order: Optional[np.ndarray] = None) -> Dict:
+    """
+    Write a tiled zoom pyramid: the finest level has one pixel per cell,
+    each coarser level halves the resolution, down to a single tile.
+
+    Tiles are built depth-first: each coarse tile is the 2 x 2 block mean
+    of its four finer tiles, and only finest-level tiles are read from the
+    matrix, so memory is a few tiles per level.
+
+    Returns:
+        Pyramid index (also written to <out_dir>/index.json)
+    """
+    n = matrix.n if isinstance(matrix, PairMatrix) else matrix.shape[0]
+    read = block_reader(matrix, order)
+    lut = color_lut()
+
+    sizes = [n]                                      # finest first
+    while sizes[-1] > tile_size:
+        sizes.append(-(-sizes[-1] // 2))
+    depth = len(sizes) - 1
+    for level in range(len(sizes)):
+        os.makedirs(os.path.join(out_dir, str(level)), exist_ok=True)
+
+    def build(d: int, row: int, col: int) -> np.ndarray:
+        # Values of tile (row, col) d halvings above the finest level
+        size = sizes[d]
+        r0, c0 = row * tile_size, col * tile_size
+        r1, c1 = min(r0 + tile_size, size), min(c0 + tile_size, size)
+        if d == 0:
+            values = read(r0, r1, c0, c1)
+        else:
+            finer = np.full((2 * tile_size, 2 * tile_size), np.nan)
+            for a in (0, 1):
+                for b in (0, 1):
+                    child_row, child_col = 2 * row + a, 2 * col + b
+                    if max(child_row, child_col) * tile_size < sizes[d - 1]:
+                        part = build(d - 1, child_row, child_col)
+                        finer[a * tile_size:a * tile_size + part.shape[0],
+                              b * tile_size:b * tile_size + part.shape[1]] = part
+            values = block_mean(finer, 2)[:r1 - r0, :c1 - c0]
+        write_png(os.path.join(out_dir, str(depth - d), f"{row}_{col}.png"),
+                  colorize(values, lut, vmin, vmax))
+        return values
+
+    build(depth, 0, 0)
+
+    index = {
+        'symbols': list(symbols),
+        'tile_size': tile_size,
+        'levels': sizes[::-1],
+        'vmin': vmin,
+        'vmax': vmax,
+    }
+    with open(os.path.join(out_dir, 'index.json'), 'w') as f:
+        json.dump(index, f)
+    return index
@@ -0,0 +1,159 @@
+"""
+Kernel Dispatch - CPU feature tier selection for the numerical kernels
+
+The kernels in this project (moments, correlation tiles, Dickey-Fuller
+regressions, rolling statistics, the mock generator) are numpy/BLAS code.
+NumPy's ufuncs and OpenBLAS already pick SSE4.2 / AVX2 / AVX-512 code paths
+via CPUID when they load. This module detects the host tier the same way and,
+when STATARB_KERNEL_VARIANT is set, pins both libraries to that tier so
+variants can be benchmarked against each other on one machine.
+
+It must be imported before numpy: the pins are environment variables read
+once when numpy and OpenBLAS initialize.
+
+On NumPy 2.x the x86-64 baseline is X86_V2, which already includes SSE4.2,
+so 'scalar' and 'sse42' pin numpy identically; they differ only in the
+OpenBLAS kernel family.
+"""
+
+import os
+import platform
+import sys
+import warnings
+from importlib import metadata
+from typing import Dict, List, Set
+
+ENV_OVERRIDE = 'STATARB_KERNEL_VARIANT'
+
+# Tiers from lowest to highest
+VARIANTS = ('scalar', 'sse42', 'avx2', 'avx512')
+
+# /proc/cpuinfo flags required for each tier
+REQUIRED_FLAGS = {
+    'sse42': {'sse4_2', 'popcnt'},
+    'avx2': {'avx', 'avx2', 'fma'},
+    'avx512': {'avx512f', 'avx512cd', 'avx512bw', 'avx512dq', 'avx512vl'},
+}
+
+# NumPy dispatch targets introduced by each tier, by NumPy major version.
+# Baseline features (SSE..SSE3 on 1.x, X86_V2 on 2.x) can never be disabled,
+# so 'scalar' is bounded by the baseline numpy was built with; on 2.x the
+# 'sse42' tier adds nothing above it.
+NUMPY_TIER_FEATURES = {
+    1: {
+        'sse42': ['SSSE3', 'SSE41', 'POPCNT', 'SSE42'],
+        'avx2': ['AVX', 'F16C', 'FMA3', 'AVX2'],
+        'avx512': ['AVX512F', 'AVX512CD', 'AVX512_KNL', 'AVX512_KNM', 'AVX512_SKX',
+                   'AVX512_CLX', 'AVX512_CNL', 'AVX512_ICL', 'AVX512_SPR'],
+    },
+    2: {
+        'sse42': [],
+        'avx2': ['X86_V3'],
+        'avx512': ['X86_V4', 'AVX512_ICL', 'AVX512_SPR'],
+    },
+}
+
+# OpenBLAS kernel family used for each tier
+OPENBLAS_CORETYPES = {
+    'scalar': 'Prescott',
+    'sse42': 'Nehalem',
+    'avx2': 'Haswell',
+    'avx512': 'SkylakeX',
+}
+
+
+def cpu_flags() -> Set[str]:
+    """
+    CPU feature flags reported by the OS (Linux /proc/cpuinfo).
+    """
+    try:
+        with open('/proc/cpuinfo') as f:
+            for line in f:
+                if line.startswith('flags'):
+                    return set(line.split(':', 1)[1].split())
+    except OSError:
+        pass
+    return set()
+
+
+def detect_variant() -> str:
+    """
+    Highest tier the host supports.
+    """
+    if platform.machine().lower() not in ('x86_64', 'amd64'):
+        return 'scalar'
+
+    flags = cpu_flags()
+    if not flags:
+        # No flag source (non-Linux); every x86-64 host we run on has AVX2
+        return 'avx2'
+
+    best = 'scalar'
+    for variant in VARIANTS[1:]:
+        if not REQUIRED_FLAGS[variant] <= flags:
+            break
+        best = variant
+    return best
+
+
+def numpy_major() -> int:
+    """
+    Installed NumPy major version, read from package metadata without importing it.
+    """
+    try:
+        return 1 if metadata.version('numpy').split('.')[0] == '1' else 2
+    except metadata.PackageNotFoundError:
+        return 2
+
+
+def disabled_numpy_features(variant: str) -> List[str]:
+    """
+    NumPy dispatch targets above the given tier.
+    """
+    features = NUMPY_TIER_FEATURES[numpy_major()]
+    above = VARIANTS[VARIANTS.index(variant) + 1:]
+    return [feature for tier in above for feature in features[tier]]
+
+
+def configure(variant: str = None) -> Dict[str, str]:
+    """
+    Select the kernel tier and pin numpy/OpenBLAS to it when overridden.
+
+    Without an override the libraries keep their own CPUID dispatch, which
+    already matches the detected tier.
+
+    Args:
+        variant: Forced tier; defaults to $STATARB_KERNEL_VARIANT
+
+    Returns:
+        Dictionary with 'detected', 'active' and 'source' ('cpuid' or 'override')
+    """
+    detected = detect_variant()
+    requested = (variant or os.environ.get(ENV_OVERRIDE, '')).strip().lower()
+
+    if not requested:
+        return {'detected': detected, 'active': detected, 'source': 'cpuid'}
+
+    if requested not in VARIANTS:
+        raise ValueError(f"{ENV_OVERRIDE}={requested!r}; expected one of {', '.join(VARIANTS)}")
+
+    if VARIANTS.index(requested) > VARIANTS.index(detected):
+        print(f"⚠️  Kernel variant '{requested}' not supported by this CPU; using '{detected}'")
+        requested = detected
+
+    if 'numpy' in sys.modules:
+        print(f"⚠️  numpy already imported; kernel variant '{requested}' only applies to new processes")
+
+    disabled = disabled_numpy_features(requested)
+    if disabled:
+        os.environ.setdefault('NPY_DISABLE_CPU_FEATURES', ' '.join(disabled))
+        # numpy warns at import about names its build does not dispatch
+        # (e.g. AVX512_SPR on older releases); those are already off
+        warnings.filterwarnings('ignore', message='During parsing environment variable',
+                                category=ImportWarning)
+    os.environ.setdefault('OPENBLAS_CORETYPE', OPENBLAS_CORETYPES[requested])
+
+    return {'detected': detected, 'active': requested, 'source': 'override'}
+
+
+ACTIVE = configure()
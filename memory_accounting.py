@@ -0,0 +1,221 @@
+"""
+Memory Accounting - Per-stage allocation and RSS instrumentation
+
+Attributes memory to named analyzer stages and engine calls:
+
+- tracemalloc gives the net bytes a stage left allocated and the peak of
+  live traced memory inside it (numpy registers its data buffers with
+  tracemalloc, so array temporaries are included)
+- sys.getallocatedblocks() gives the net change in interpreter-allocated
+  blocks (dict rows, Python floats in result lists, ...)
+- a sampler thread reads the process RSS while stages are open, catching
+  memory that tracemalloc cannot see (BLAS workspaces, pandas internals in C)
+
+Disabled by default; tracking is off unless STATARB_MEMORY_TRACE=1 is set
+or enable() is called, and then stage() costs one flag check.
+"""
+
+import functools
+import json
+import os
+import resource
+import sys
+import threading
+import time
+import tracemalloc
+from contextlib import contextmanager
+from typing import Callable, Dict, List, Optional
+
+ENV_ENABLE = 'STATARB_MEMORY_TRACE'
+
+# RSS sampling period while at least one stage is open
+RSS_SAMPLE_INTERVAL = 0.005
+
+# Frames kept per traced allocation; 1 is enough for attribution by stage
+TRACE_FRAMES = 1
+
+_PAGE_SIZE = os.sysconf('SC_PAGE_SIZE') if hasattr(os, 'sysconf') else 4096
+
+
+def current_rss() -> int:
+    """
+    Resident set size of this process in bytes (0 where unavailable).
+    """
+    try:
+        with open('/proc/self/statm') as f:
+            return int(f.read().split()[1]) * _PAGE_SIZE
+    except (OSError, IndexError, ValueError):
+        return 0
+
+
+def peak_rss() -> int:
+    """
+    Lifetime peak RSS of this process in bytes.
+    """
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # Linux reports kilobytes, macOS bytes
+    return peak if sys.platform == 'darwin' else peak * 1024
+
+
+class _StageFrame:
+    def __init__(self, path: str):
+        self.path = path
+        self.start_time = time.perf_counter()
+        self.start_traced = tracemalloc.get_traced_memory()[0]
+        self.start_blocks = sys.getallocatedblocks()
+        self.start_rss = current_rss()
+        self.peak_traced = self.start_traced
+        self.peak_rss = self.start_rss
+
+
+class MemoryTracker:
+    """
+    Collects per-stage memory records; stages nest and are reported by path.
+
+    Stages are opened from the driving thread; engine thread pools inside a
+    stage are attributed to it.
+    """
+
+    def __init__(self):
+        self.enabled = False
+        self.records: List[Dict] = []
+        self._stack: List[_StageFrame] = []
+        self._lock = threading.Lock()
+        self._sampler: Optional[threading.Thread] = None
+        self._sampling = threading.Event()
+
+    def enable(self):
+        """
+        Start tracemalloc (if needed) and begin recording stages.
+        """
+        if not tracemalloc.is_tracing():
+            tracemalloc.start(TRACE_FRAMES)
+        self.enabled = True
+
+    def disable(self):
+        self.enabled = False
+        self._stop_sampler()
+        if tracemalloc.is_tracing():
+            tracemalloc.stop()
+
+    def reset(self):
+        self.records = []
+
+    def _sample_rss(self):
+        while not self._sampling.wait(RSS_SAMPLE_INTERVAL):
+            rss = current_rss()
+            with self._lock:
+                for frame in self._stack:
+                    if rss > frame.peak_rss:
+                        frame.peak_rss = rss
+
+    def _start_sampler(self):
+        self._sampling.clear()
+        self._sampler = threading.Thread(target=self._sample_rss, name='rss-sampler', daemon=True)
+        self._sampler.start()
+
+    def _stop_sampler(self):
+        if self._sampler is not None:
+            self._sampling.set()
+            self._sampler.join()
+            self._sampler = None
+
+    @contextmanager
+    def stage(self, name: str):
+        """
+        Attribute allocations inside the block to a named stage.
+
+        Nested stages are recorded as 'outer/inner'; the outer stage's peak
+        includes its children's.
+        """
+        if not self.enabled:
+            yield
+            return
+
+        with self._lock:
+            parent = self._stack[-1] if self._stack else None
+            if parent is not None:
+                # Fold the parent's peak so far before the child resets it
+                parent.peak_traced = max(parent.peak_traced, tracemalloc.get_traced_memory()[1])
+            tracemalloc.reset_peak()
+            frame = _StageFrame(f"{parent.path}/{name}" if parent else name)
+            self._stack.append(frame)
+            if self._sampler is None:
+                self._start_sampler()
+
+        try:
+            yield
+        finally:
+            current, peak = tracemalloc.get_traced_memory()
+            rss = current_rss()
+            with self._lock:
+                self._stack.pop()
+                frame.peak_traced = max(frame.peak_traced, peak)
+                frame.peak_rss = max(frame.peak_rss, rss)
+                if self._stack:
+                    outer = self._stack[-1]
+                    outer.peak_traced = max(outer.peak_traced, frame.peak_traced)
+                    outer.peak_rss = max(outer.peak_rss, frame.peak_rss)
+                else:
+                    self._stop_sampler()
+
+                self.records.append({
+                    'stage': frame.path,
+                    'seconds': time.perf_counter() - frame.start_time,
+                    'net_bytes': current - frame.start_traced,
+                    'peak_live_bytes': frame.peak_traced - frame.start_traced,
+                    'net_blocks': sys.getallocatedblocks() - frame.start_blocks,
+                    'rss_start': frame.start_rss,
+                    'rss_peak_delta': frame.peak_rss - frame.start_rss,
+                })
+
+    def tracked(self, name: Optional[str] = None) -> Callable:
+        """
+        Decorator form of stage(); defaults to the function's name.
+        """
+        def decorator(func: Callable) -> Callable:
+            stage_name = name or func.__name__
+
+            @functools.wraps(func)
+            def wrapper(*args, **kwargs):
+                if not self.enabled:
+                    return func(*args, **kwargs)
+                with self.stage(stage_name):
+                    return func(*args, **kwargs)
+            return wrapper
+        return decorator
+
+    def report(self) -> List[Dict]:
+        """
+        Recorded stages in completion order, plus the process peak RSS.
+        """
+        return [dict(record) for record in self.records] + [
+            {'stage': '<process>', 'peak_rss': peak_rss()}
+        ]
+
+    def format_report(self) -> str:
+        """
+        Human-readable per-stage table (MB).
+        """
+        lines = [f"{'stage':<48} {'sec':>8} {'net MB':>9} {'peak MB':>9} {'RSS+ MB':>9} {'blocks':>10}"]
+        for r in self.records:
+            lines.append(
+                f"{r['stage']:<48} {r['seconds']:>8.3f} {r['net_bytes'] / 1e6:>9.2f} "
+                f"{r['peak_live_bytes'] / 1e6:>9.2f} {r['rss_peak_delta'] / 1e6:>9.2f} {r['net_blocks']:>10d}"
+            )
+        lines.append(f"process peak RSS: {peak_rss() / 1e6:.1f} MB")
+        return '\n'.join(lines)
+
+    def save_report(self, path: str):
+        """
+        Write the report as JSON (for benchmark comparisons across runs).
+        """
+        with open(path, 'w') as f:
+            json.dump(self.report(), f, indent=2)
+
+
+# Process-wide tracker used by the analyzer
+MEMORY = MemoryTracker()
+
+if os.environ.get(ENV_ENABLE, '').strip() not in ('', '0'):
+    MEMORY.enable()
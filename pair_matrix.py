@@ -0,0 +1,250 @@
+"""
+Pair Matrix - Packed upper-triangular storage for N x N pair statistics
+
+Symmetric matrices (correlation) and pair-indexed statistics (p-value,
+hedge ratio, half-life for symbol1 < symbol2) only need the upper triangle.
+PairMatrix stores it row-major in one flat array, so an N-symbol matrix costs
+N(N+1)/2 values (N(N-1)/2 without the diagonal) instead of N^2.
+
+With the strict layout, the linear index of (i, j), i < j, is the position of
+that pair in itertools.combinations(range(N), 2).
+"""
+
+import json
+import numpy as np
+from typing import Iterator, List, Sequence, Tuple, Union
+
+Key = Union[int, str]
+
+
+class PairMatrix:
+    """
+    Packed upper-triangular N x N matrix with O(1) (i, j) <-> index mapping.
+    """
+
+    def __init__(self, symbols: Sequence[str], diagonal: bool = True,
+                 dtype=np.float64, fill: float = np.nan, data: np.ndarray = None):
+        """
+        Args:
+            symbols: Row/column labels
+            diagonal: Store the diagonal (True for correlation-like matrices)
+            dtype: Element type
+            fill: Initial value when no data is given
+            data: Existing packed array (e.g. a memory map) to wrap
+        """
+        self.symbols = list(symbols)
+        self.n = len(self.symbols)
+        self.diagonal = diagonal
+        self._lookup = {symbol: i for i, symbol in enumerate(self.symbols)}
+
+        size = self.packed_size(self.n, diagonal)
+        if data is None:
+            data = np.full(size, fill, dtype=dtype)
+        elif len(data) != size:
+            raise ValueError(f"Packed data has {len(data)} values, expected {size} for N={self.n}")
+        self.data = data
+
+    @staticmethod
+    def packed_size(n: int, diagonal: bool = True) -> int:
+        return n * (n + 1) // 2 if diagonal else n * (n - 1) // 2
+
+    @property
+    def nbytes(self) -> int:
+        return self.data.nbytes
+
+    def _position(self, key: Key) -> int:
+        return self._lookup[key] if isinstance(key, str) else int(key)
+
+    def index(self, i: Key, j: Key) -> int:
+        """
+        Linear index of element (i, j); symmetric, so (j, i) maps to the same slot.
+        """
+        i, j = self._position(i), self._position(j)
+        if i > j:
+            i, j = j, i
+        if self.diagonal:
+            return i * self.n - i * (i - 1) // 2 + (j - i)
+        if i == j:
+            raise KeyError("Diagonal is not stored in a strict PairMatrix")
+        return i * (2 * self.n - i - 1) // 2 + (j - i - 1)
+
+    def pair(self, index: int) -> Tuple[int, int]:
+        """
+        Inverse of index(): the (i, j), i <= j, stored at a linear index.
+        """
+        rows, cols = self.pairs(np.array([index]))
+        return int(rows[0]), int(cols[0])
+
+    def pairs(self, indices: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Vectorized pair(): row and column arrays for an array of linear indices.
+        """
+        k = np.asarray(indices, dtype=np.int64)
+        m = self.n if self.diagonal else self.n - 1
+        # Row i starts at i*m - i(i-1)/2; solve the quadratic for the largest such i,
+        # then correct the floating-point estimate by one row either way
+        i = np.floor(((2 * m + 1) - np.sqrt((2 * m + 1) ** 2 - 8.0 * k)) / 2).astype(np.int64)
+        row_start = i * m - i * (i - 1) // 2
+        i -= row_start > k
+        row_start = i * m - i * (i - 1) // 2
+        past = k >= row_start + (m - i)
+        i += past
+        row_start = i * m - i * (i - 1) // 2
+        offset = k - row_start
+        return i, (i + offset if self.diagonal else i + 1 + offset)
+
+    def __getitem__(self, key: Tuple[Key, Key]) -> float:
+        i, j = key
+        if not self.diagonal and self._position(i) == self._position(j):
+            return np.nan
+        return self.data[self.index(i, j)]
+
+    def __setitem__(self, key: Tuple[Key, Key], value: float):
+        i, j = key
+        self.data[self.index(i, j)] = value
+
+    def row_segment(self, i: int, start: int, stop: int) -> slice:
+        """
+        Slice of the packed array holding row i, columns [start, stop) of the
+        upper triangle (start is clamped to the first stored column).
+        """
+        first = i if self.diagonal else i + 1
+        start = max(start, first)
+        if stop <= start:
+            return slice(0, 0)
+        begin = self.index(i, start)
+        return slice(begin, begin + (stop - start))
+
+    def tiles(self, tile_size: int = 256) -> Iterator[Tuple[slice, slice]]:
+        """
+        Iterate upper-triangular (row block, column block) tiles.
+
+        Blocks on or above the diagonal are visited row-block by row-block,
+        so consecutive tiles write neighbouring packed segments.
+        """
+        for row_start in range(0, self.n, tile_size):
+            rows = slice(row_start, min(row_start + tile_size, self.n))
+            for col_start in range(row_start, self.n, tile_size):
+                yield rows, slice(col_start, min(col_start + tile_size, self.n))
+
+    def set_tile(self, rows: slice, cols: slice, block: np.ndarray):
+        """
+        Store the upper-triangular part of a dense (rows x cols) tile.
+        """
+        for offset, i in enumerate(range(rows.start, rows.stop)):
+            segment = self.row_segment(i, cols.start, cols.stop)
+            length = segment.stop - segment.start
+            if length > 0:
+                self.data[segment] = block[offset, block.shape[1] - length:]
+
+    def _upper_block(self, rows: slice, cols: slice) -> np.ndarray:
+        # Stored (upper-triangular) part of a tile, NaN below the diagonal
+        width = cols.stop - cols.start
+        block = np.full((rows.stop - rows.start, width), np.nan, dtype=self.data.dtype)
+        for offset, i in enumerate(range(rows.start, rows.stop)):
+            segment = self.row_segment(i, cols.start, cols.stop)
+            length = segment.stop - segment.start
+            if length > 0:
+                block[offset, width - length:] = self.data[segment]
+        return block
+
+    def get_tile(self, rows: slice, cols: slice) -> np.ndarray:
+        """
+        Dense (rows x cols) tile, mirrored from the packed upper triangle.
+
+        Each row is one packed segment; the part below the diagonal is the
+        transposed (cols x rows) tile, read the same way.
+        """
+        block = self._upper_block(rows, cols)
+        row_ids = np.arange(rows.start, rows.stop)[:, None]
+        col_ids = np.arange(cols.start, cols.stop)[None, :]
+        below = col_ids < row_ids
+        if below.any():
+            block = np.where(below, self._upper_block(cols, rows).T, block)
+        return block
+
+    def take(self, rows: np.ndarray, cols: np.ndarray) -> np.ndarray:
+        """
+        Dense (len(rows) x len(cols)) block for arbitrary row and column
+        positions, e.g. a tile of a reordered matrix; one gather from the
+        packed array.
+        """
+        i = np.asarray(rows, dtype=np.int64)[:, None]
+        j = np.asarray(cols, dtype=np.int64)[None, :]
+        lo, hi = np.minimum(i, j), np.maximum(i, j)
+        if self.diagonal:
+            return self.data[lo * self.n - lo * (lo - 1) // 2 + (hi - lo)]
+        if not len(self.data):
+            return np.full(lo.shape, np.nan)
+        index = lo * (2 * self.n - lo - 1) // 2 + (hi - lo - 1)
+        block = self.data[np.maximum(index, 0)]
+        block[lo == hi] = np.nan
+        return block
+
+    def upper_items(self, chunk: int = 1 << 20) -> Iterator[Tuple[np.ndarray, np.ndarray, np.ndarray]]:
+        """
+        Iterate stored elements in packed order as (rows, cols, values)
+        arrays of at most `chunk` elements.
+        """
+        for start in range(0, len(self.data), chunk):
+            stop = min(start + chunk, len(self.data))
+            rows, cols = self.pairs(np.arange(start, stop))
+            yield rows, cols, self.data[start:stop]
+
+    def to_dense(self) -> np.ndarray:
+        """
+        Expand to a symmetric N x N array (for small N, e.g. plotting).
+        """
+        dense = np.full((self.n, self.n), np.nan if not self.diagonal else 0, dtype=self.data.dtype)
+        k = 1 if not self.diagonal else 0
+        rows, cols = np.triu_indices(self.n, k=k)
+        dense[rows, cols] = self.data
+        dense[cols, rows] = self.data
+        if not self.diagonal:
+            np.fill_diagonal(dense, np.nan)
+        return dense
+
+    def to_dataframe(self) -> 'pd.DataFrame':
+        import pandas as pd   # deferred: the scan CLI never builds frames
+        return pd.DataFrame(self.to_dense(), index=self.symbols, columns=self.symbols)
+
+    @classmethod
+    def from_dense(cls, matrix: np.ndarray, symbols: Sequence[str], diagonal: bool = True) -> 'PairMatrix':
+        """
+        Pack the upper triangle of a dense matrix ([i, j] with i <= j).
+        """
+        rows, cols = np.triu_indices(len(symbols), k=0 if diagonal else 1)
+        return cls(symbols, diagonal=diagonal, data=np.ascontiguousarray(matrix[rows, cols]))
+
+    @classmethod
+    def from_pairs(cls, symbols: Sequence[str], pairs: List[Tuple[str, str]],
+                   values: Sequence[float]) -> 'PairMatrix':
+        """
+        Build a strict pair-indexed matrix from (symbol1, symbol2) -> value.
+        """
+        matrix = cls(symbols, diagonal=False)
+        for (symbol1, symbol2), value in zip(pairs, values):
+            matrix[symbol1, symbol2] = value
+        return matrix
+
+    def save(self, path: str):
+        """
+        Persist as a .npy file (memory-mappable) plus a JSON sidecar with the labels.
+        """
+        stored = np.lib.format.open_memmap(path, mode='w+', dtype=self.data.dtype, shape=self.data.shape)
+        stored[:] = self.data
+        stored.flush()
+        del stored
+
+        with open(path + '.json', 'w') as f:
+            json.dump({'symbols': self.symbols, 'diagonal': self.diagonal}, f)
+
+    @classmethod
+    def load(cls, path: str, mmap_mode: str = 'r') -> 'PairMatrix':
+        """
+        Open a saved matrix; by default the values are memory-mapped, not read.
+        """
+        with open(path + '.json') as f:
+            meta = json.load(f)
+        data = np.load(path, mmap_mode=mmap_mode)
+        return cls(meta['symbols'], diagonal=meta['diagonal'], data=data)
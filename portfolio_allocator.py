@@ -0,0 +1,306 @@
+"""
+Portfolio Allocator - Capital across ranked pairs under the configured limits
+
+Weights are fractions of capital committed to each pair's spread position
+and satisfy the limits from config.py:
+
+    0 <= w_i <= position_size_pct          (STRATEGY_CONFIG)
+    sum(w) <= max_total_exposure           (RISK_CONFIG)
+    at most max_positions non-zero w_i     (STRATEGY_CONFIG)
+
+Two objectives are supported:
+
+- 'mean_variance': maximize mu^T w - (lambda / 2) w^T Sigma w, solved by
+  accelerated projected gradient (FISTA). The projection onto the capped
+  simplex is exact (one sort of its 2P breakpoints), so each iteration is
+  one matrix-vector product plus an O(P log P) projection.
+- 'risk_parity': equal (or score-proportional) risk contributions by cyclic
+  coordinate descent on 1/2 y^T Sigma y - sum b_i log y_i, then scaled to the
+  exposure budget.
+
+Expected edges are dimensionless scores (Sharpe-like, e.g. the composite
+score). Mean-variance uses mu_i = score_i * sigma_i / mean(sigma) against
+Sigma / mean(sigma)^2, so risk_aversion does not depend on bar size.
+Solutions are kept and used to warm-start the next solve, so re-solving
+every bar takes a few iterations.
+"""
+
+import numpy as np
+from typing import Dict, Optional
+
+METHODS = ('mean_variance', 'risk_parity')
+
+DEFAULT_RISK_AVERSION = 10.0
+
+# Weight of the diagonal in the shrunk spread covariance
+DEFAULT_SHRINKAGE = 0.1
+
+
+def pair_returns(prices: np.ndarray, idx1: np.ndarray, idx2: np.ndarray,
+                 hedge_ratios: np.ndarray) -> np.ndarray:
+    """
+    Per-bar return on gross capital of a long position in each spread.
+
+    The spread y - beta * x ties up |y| + |beta| * |x| of capital, so the
+    return of bar t is the spread change over the previous bar's gross.
+
+    Args:
+        prices: (T x N) aligned close matrix
+        idx1: (P,) column of each pair's first symbol
+        idx2: (P,) column of each pair's second symbol
+        hedge_ratios: (P,) hedge ratios
+
+    Returns:
+        (T-1 x P) returns
+    """
+    y, x = prices[:, idx1], prices[:, idx2]
+    spread = y - x * hedge_ratios
+    gross = np.abs(y) + np.abs(x * hedge_ratios)
+    return np.diff(spread, axis=0) / gross[:-1]
+
+
+def shrunk_covariance(returns: np.ndarray, shrinkage: float = DEFAULT_SHRINKAGE) -> np.ndarray:
+    """
+    Sample covariance shrunk toward its diagonal (keeps it well conditioned
+    when pairs share legs).
+    """
+    cov = np.atleast_2d(np.cov(returns, rowvar=False))
+    return (1 - shrinkage) * cov + shrinkage * np.diag(np.diag(cov))
+
+
+def project_capped_simplex(v: np.ndarray, caps: np.ndarray, budget: float) -> np.ndarray:
+    """
+    Euclidean projection onto {0 <= w <= caps, sum(w) <= budget}.
+
+    The projection is clip(v - tau, 0, caps) for the smallest tau >= 0 that
+    meets the budget. sum(clip(v - tau, 0, caps)) is piecewise linear in tau
+    with breakpoints at v_i and v_i - caps_i, so tau is found exactly with
+    one sort of the 2P breakpoints.
+
+    A zero budget admits only w = 0; a negative one is infeasible.
+    """
+    if budget < 0:
+        raise ValueError(f"Budget must be non-negative, got {budget}")
+    if budget == 0:
+        return np.zeros(len(v))
+
+    w = np.clip(v, 0.0, caps)
+    if w.sum() <= budget:
+        return w
+
+    # Walking tau down through the breakpoints, a coordinate starts growing
+    # at v_i (slope +1) and saturates at v_i - caps_i (slope -1)
+    points = np.concatenate([v, v - caps])
+    slopes = np.concatenate([np.ones(len(v)), -np.ones(len(v))])
+    order = np.argsort(-points, kind='stable')
+    points, slopes = points[order], slopes[order]
+    active = np.cumsum(slopes)[:-1]                  # growing coordinates between breakpoints
+    totals = np.concatenate([[0.0], np.cumsum(active * -np.diff(points))])
+    k = int(np.searchsorted(totals, budget, side='left'))
+    tau = points[k - 1] - (budget - totals[k - 1]) / active[k - 1]
+    return np.clip(v - max(tau, 0.0), 0.0, caps)
+
+
+def mean_variance_weights(mu: np.ndarray, cov: np.ndarray, caps: np.ndarray, budget: float,
+                          risk_aversion: float = DEFAULT_RISK_AVERSION,
+                          w0: Optional[np.ndarray] = None, max_iter: int = 500,
+                          tol: float = 1e-9) -> np.ndarray:
+    """
+    Maximize mu^T w - (risk_aversion / 2) w^T cov w over the capped simplex.
+
+    Args:
+        mu: (P,) expected returns
+        cov: (P x P) covariance
+        caps: (P,) per-pair upper bounds
+        budget: Upper bound on sum(w)
+        risk_aversion: lambda
+        w0: Warm start
+        max_iter: Iteration limit
+        tol: Stop when the step norm falls below this
+
+    Returns:
+        (P,) weights
+    """
+    # Step 1 / L with L the largest eigenvalue of the quadratic term
+    lipschitz = risk_aversion * max(np.linalg.eigvalsh(cov)[-1], 1e-300)
+    step = 1.0 / lipschitz
+
+    w = project_capped_simplex(np.zeros_like(mu) if w0 is None else w0, caps, budget)
+    z, t = w.copy(), 1.0
+    for _ in range(max_iter):
+        gradient = mu - risk_aversion * (cov @ z)
+        w_next = project_capped_simplex(z + step * gradient, caps, budget)
+        delta = w_next - w
+        if delta @ delta < tol * tol:
+            return w_next
+        if (z - w_next) @ delta > 0:
+            # Momentum points uphill on the objective: restart acceleration
+            t = 1.0
+        t_next = 0.5 * (1 + np.sqrt(1 + 4 * t * t))
+        z = w_next + ((t - 1) / t_next) * delta
+        w, t = w_next, t_next
+    return w
+
+
+def risk_parity_weights(cov: np.ndarray, budgets: np.ndarray, caps: np.ndarray, total: float,
+                        y0: Optional[np.ndarray] = None, max_sweeps: int = 200,
+                        tol: float = 1e-10) -> np.ndarray:
+    """
+    Risk-budgeting weights: w_i * (cov w)_i proportional to budgets_i.
+
+    Cyclic coordinate descent on 1/2 y^T cov y - sum b_i log y_i; each
+    coordinate has the closed-form positive root of
+    cov_ii y_i^2 + c_i y_i - b_i = 0 with c_i = (cov y)_i - cov_ii y_i.
+    The solution is scaled to `total`; pairs above their cap are fixed at
+    the cap and the rest are rescaled to fill the remainder.
+
+    Returns:
+        (P,) weights
+    """
+    b = budgets / budgets.sum()
+    diag = np.diag(cov)
+    y = (np.sqrt(b / diag) if y0 is None else y0.copy())
+    sigma_y = cov @ y
+    for _ in range(max_sweeps):
+        largest = 0.0
+        for i in range(len(y)):
+            c = sigma_y[i] - diag[i] * y[i]
+            new = (-c + np.sqrt(c * c + 4 * diag[i] * b[i])) / (2 * diag[i])
+            change = new - y[i]
+            if change != 0.0:
+                sigma_y += cov[:, i] * change
+                y[i] = new
+                largest = max(largest, abs(change) / new)
+        if largest < tol:
+            break
+
+    w = y / y.sum() * total
+    capped = np.zeros(len(w), dtype=bool)
+    while True:
+        over = (w > caps) & ~capped
+        if not over.any():
+            return w
+        capped |= over
+        w[capped] = caps[capped]
+        remaining = total - w[capped].sum()
+        free = ~capped
+        if not free.any() or remaining <= 0:
+            w[free] = 0.0
+            return w
+        w[free] = y[free] / y[free].sum() * remaining
+
+
+class PortfolioAllocator:
+    """
+    Re-solvable allocation across pairs with warm starts between calls.
+    """
+
+    def __init__(self, max_total_exposure: float = 0.5, position_size_pct: float = 0.1,
+                 max_positions: int = 5, method: str = 'mean_variance',
+                 risk_aversion: float = DEFAULT_RISK_AVERSION, max_iter: int = 500):
+        """
+        Args:
+            max_total_exposure: Upper bound on the sum of weights (RISK_CONFIG)
+            position_size_pct: Upper bound on each weight (STRATEGY_CONFIG)
+            max_positions: Maximum number of pairs held (STRATEGY_CONFIG)
+            method: 'mean_variance' or 'risk_parity'
+            risk_aversion: Mean-variance lambda on normalized covariance
+            max_iter: Iteration (or sweep) limit per solve
+        """
+        if method not in METHODS:
+            raise ValueError(f"Unknown allocation method '{method}'; expected one of {', '.join(METHODS)}")
+        if max_total_exposure < 0:
+            raise ValueError(f"max_total_exposure must be non-negative, got {max_total_exposure}")
+        self.max_total_exposure = max_total_exposure
+        self.position_size_pct = position_size_pct
+        self.max_positions = max_positions
+        self.method = method
+        self.risk_aversion = risk_aversion
+        self.max_iter = max_iter
+        self._last = None
+
+    @classmethod
+    def from_config(cls, **overrides) -> 'PortfolioAllocator':
+        """
+        Allocator with the limits from config.py's RISK_CONFIG and STRATEGY_CONFIG.
+        """
+        from config import RISK_CONFIG, STRATEGY_CONFIG
+        settings = {
+            'max_total_exposure': RISK_CONFIG['max_total_exposure'],
+            'position_size_pct': STRATEGY_CONFIG['position_size_pct'],
+            'max_positions': STRATEGY_CONFIG['max_positions'],
+        }
+        settings.update(overrides)
+        return cls(**settings)
+
+    def allocate(self, scores: np.ndarray, cov: np.ndarray,
+                 directions: Optional[np.ndarray] = None) -> np.ndarray:
+        """
+        Weights for the current bar.
+
+        Args:
+            scores: (P,) expected edge of each pair (dimensionless, higher = better;
+                non-positive scores get no capital under mean-variance)
+            cov: (P x P) covariance of pair returns for a long spread position
+            directions: Optional (P,) +1 / -1 side of each pair's position;
+                flips the covariance signs of short spreads
+
+        Returns:
+            (P,) capital fractions
+        """
+        scores = np.asarray(scores, dtype=float)
+        cov = np.asarray(cov, dtype=float)
+        if directions is not None:
+            cov = cov * np.outer(directions, directions)
+        num_pairs = len(scores)
+        if num_pairs == 0:
+            return np.zeros(0)
+
+        sigma = np.sqrt(np.diag(cov))
+        scale = sigma.mean() if sigma.mean() > 0 else 1.0
+        cov_n = cov / (scale * scale)
+        caps = np.full(num_pairs, float(self.position_size_pct))
+        warm = self._last if self._last is not None and len(self._last) == num_pairs else None
+
+        if self.method == 'risk_parity':
+            # Risk parity holds every pair it is given: pre-select the best scores
+            weights = scores.copy()
+        else:
+            weights = self._solve(scores, sigma / scale, cov_n, caps, warm)
+        if np.count_nonzero(weights > 0) > self.max_positions or self.method == 'risk_parity':
+            # Cardinality: keep the largest positions and re-solve on them
+            active = np.sort(np.argsort(-weights, kind='stable')[:self.max_positions])
+            sub = np.ix_(active, active)
+            weights_active = self._solve(scores[active], sigma[active] / scale, cov_n[sub],
+                                         caps[active], weights[active])
+            weights = np.zeros(num_pairs)
+            weights[active] = weights_active
+
+        self._last = weights
+        return weights
+
+    def _solve(self, scores, sigma_n, cov_n, caps, warm):
+        if self.method == 'mean_variance':
+            return mean_variance_weights(scores * sigma_n, cov_n, caps, self.max_total_exposure,
+                                         self.risk_aversion, warm, self.max_iter)
+
+        budgets = np.clip(scores, 1e-12, None)
+        total = min(self.max_total_exposure, caps.sum())
+        return risk_parity_weights(cov_n, budgets, caps, total, max_sweeps=self.max_iter)
+
+    def reset(self):
+        """
+        Drop the warm start (e.g. after the pair universe changes).
+        """
+        self._last = None
+
+
+def risk_contributions(weights: np.ndarray, cov: np.ndarray) -> Dict[str, np.ndarray]:
+    """
+    Portfolio volatility and each pair's share of the variance.
+    """
+    marginal = cov @ weights
+    variance = float(weights @ marginal)
+    with np.errstate(divide='ignore', invalid='ignore'):
+        share = weights * marginal / variance if variance > 0 else np.zeros_like(weights)
+    return {'volatility': np.sqrt(max(variance, 0.0)), 'contribution': share}
@@ -0,0 +1,260 @@
+"""
+Regime HMM - Batched Gaussian hidden Markov models on spread residuals
+
+Each pair's residual series is modeled as a K-state (2-3) Gaussian HMM.
+States differ in mean and variance, so a cointegrated spread sits in a calm
+state and a breakdown shows up as a persistent move into a volatile or
+shifted one.
+
+All pairs are fitted together in structure-of-arrays layout: every
+parameter and probability is state-major with the pair as the contiguous
+last axis ((K, P) means and variances, (K, K, P) transitions, (T, K, P)
+alphas and betas). Each time step of forward-backward is then a handful of
+contiguous length-P array operations, whatever the number of pairs.
+
+- Forward and backward use scaled probabilities (Rabiner scaling); the
+  log-likelihood is the sum of the log scale factors.
+- Only the beta recursion runs in the backward loop; gamma, xi and the
+  Baum-Welch sufficient statistics are reduced over time afterwards.
+- Results are returned pair-major ((P, K), (P, K, K)) with states relabeled
+  so state 0 has the smallest variance.
+- RegimeFilter continues the forward recursion one bar at a time for the
+  live engine (O(P K^2) per bar), on raw residuals and the fit's scale.
+"""
+
+import os
+import numpy as np
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, Optional
+
+# Most pair columns per batch; the per-step cost is mostly fixed overhead, so
+# batches are wide when the series are short
+PAIR_CHUNK = 256
+
+# Steps x states x pairs cells per batch. A batch peaks at about 11 live
+# working arrays of this many float64s (11 x 8 bytes x STATE_CELLS, ~46 MB),
+# so long series get narrower batches
+STATE_CELLS = 1 << 19
+
+# Worker threads by default; peak memory is about workers x one batch (~185 MB)
+DEFAULT_WORKERS = 4
+
+DEFAULT_STATES = 2
+DEFAULT_MAX_ITER = 50
+# Stop when the mean log-likelihood per observation improves less than this
+DEFAULT_TOL = 1e-5
+
+# Variances are floored at this fraction of each series' variance
+VAR_FLOOR = 1e-4
+
+# Diagonal of the initial transition matrix
+INITIAL_STAY = 0.95
+
+
+def _emissions(obs: np.ndarray, mean: np.ndarray, var: np.ndarray):
+    """
+    State likelihoods of each observation, rescaled per (t, pair).
+
+    Args:
+        obs: (T, P) observations
+        mean, var: (K, P) state parameters
+
+    Returns:
+        Tuple of ((T, K, P) likelihoods divided by their max over states,
+        (T, P) log of that max)
+    """
+    diff = obs[:, None, :] - mean[None]
+    log_b = -0.5 * (np.log(2 * np.pi * var)[None] + diff * diff / var[None])
+    peak = log_b.max(axis=1)
+    return np.exp(log_b - peak[:, None, :]), peak
+
+
+def _forward(b: np.ndarray, start: np.ndarray, trans: np.ndarray):
+    """
+    Scaled forward pass.
+
+    Args:
+        b: (T, K, P) emission likelihoods
+        start: (K, P) initial state probabilities
+        trans: (K, K, P) transition probabilities [from, to, pair]
+
+    Returns:
+        Tuple of ((T, K, P) normalized alphas, (T, P) scale factors)
+    """
+    num_steps = len(b)
+    alpha = np.empty_like(b)
+    scale = np.empty((num_steps, b.shape[2]))
+
+    a = start * b[0]
+    scale[0] = a.sum(axis=0)
+    alpha[0] = a / scale[0]
+    for t in range(1, num_steps):
+        a = (alpha[t - 1][:, None, :] * trans).sum(axis=0) * b[t]
+        scale[t] = a.sum(axis=0)
+        alpha[t] = a / scale[t]
+    return alpha, scale
+
+
+def _backward(b: np.ndarray, scale: np.ndarray, trans: np.ndarray) -> np.ndarray:
+    """
+    Scaled backward pass: beta(t) = A (b(t+1) beta(t+1)) / c(t+1).
+
+    Returns:
+        (T, K, P) betas
+    """
+    beta = np.empty_like(b)
+    beta[-1] = 1.0
+    for t in range(len(b) - 1, 0, -1):
+        weighted = b[t] * beta[t]
+        beta[t - 1] = (trans * weighted[None, :, :]).sum(axis=1) / scale[t]
+    return beta
+
+
+def _initial_parameters(obs: np.ndarray, n_states: int):
+    # Means and variances of equal-count slices of each sorted series
+    num_steps, num_pairs = obs.shape
+    ordered = np.sort(obs, axis=0)
+    bounds = np.linspace(0, num_steps, n_states + 1).astype(int)
+    slices = list(zip(bounds[:-1], bounds[1:]))
+    mean = np.stack([ordered[lo:hi].mean(axis=0) for lo, hi in slices])
+    var = np.stack([ordered[lo:hi].var(axis=0) for lo, hi in slices])
+    floor = np.maximum(VAR_FLOOR * obs.var(axis=0), 1e-300)
+    var = np.maximum(var, floor)
+
+    trans = np.full((n_states, n_states, num_pairs), (1 - INITIAL_STAY) / max(n_states - 1, 1))
+    trans[np.arange(n_states), np.arange(n_states)] = INITIAL_STAY
+    start = np.full((n_states, num_pairs), 1.0 / n_states)
+    return start, trans, mean, var, floor
+
+
+def _fit_chunk(obs: np.ndarray, n_states: int, max_iter: int, tol: float) -> Dict[str, np.ndarray]:
+    num_steps, num_pairs = obs.shape
+    start, trans, mean, var, floor = _initial_parameters(obs, n_states)
+
+    # Each pair stops at its own convergence; later iterations only run the
+    # columns still active and leave the others' parameters frozen
+    previous = np.full(num_pairs, -np.inf)
+    iterations = np.zeros(num_pairs, dtype=int)
+    active = np.arange(num_pairs)
+    for iteration in range(1, max_iter + 1):
+        o = obs[:, active]
+        st, tr, mu, vr = start[:, active], trans[:, :, active], mean[:, active], var[:, active]
+        b, peak = _emissions(o, mu, vr)
+        alpha, scale = _forward(b, st, tr)
+        beta = _backward(b, scale, tr)
+        loglik = np.log(scale).sum(axis=0) + peak.sum(axis=0)
+
+        # E-step reductions over time, vectorized once the passes are done
+        gamma = alpha * beta
+        gamma /= gamma.sum(axis=1, keepdims=True)
+        weighted = b[1:] * beta[1:] / scale[1:, None, :]
+        xi_sum = np.einsum('tip,tjp->ijp', alpha[:-1], weighted) * tr
+
+        # M-step
+        start[:, active] = gamma[0]
+        trans[:, :, active] = xi_sum / xi_sum.sum(axis=1, keepdims=True)
+        weight = np.maximum(gamma.sum(axis=0), 1e-300)
+        mu = np.einsum('tkp,tp->kp', gamma, o) / weight
+        mean[:, active] = mu
+        var[:, active] = np.maximum(np.einsum('tkp,tp->kp', gamma, o * o) / weight - mu * mu,
+                                    floor[active])
+        iterations[active] = iteration
+
+        mean_loglik = loglik / num_steps
+        improving = mean_loglik - previous[active] >= tol
+        previous[active] = mean_loglik
+        active = active[improving]
+        if not len(active):
+            break
+
+    # Filtered probabilities at the last bar under the final parameters
+    b, peak = _emissions(obs, mean, var)
+    alpha, scale = _forward(b, start, trans)
+    loglik = np.log(scale).sum(axis=0) + peak.sum(axis=0)
+
+    # Relabel so state 0 is the calmest (smallest variance); output is pair-major
+    order = np.argsort(var, axis=0)                                  # (K, P)
+    cols = np.arange(obs.shape[1])[None, :]
+    trans = trans[order[:, None, :], order[None, :, :], cols[None]]
+    return {
+        'start': start[order, cols].T,
+        'transition': trans.transpose(2, 0, 1),
+        'mean': mean[order, cols].T,
+        'var': var[order, cols].T,
+        'state_prob': alpha[-1][order, cols].T,
+        'loglik': loglik,
+        'iterations': iterations,
+    }
+
+
+def fit_hmm(residuals: np.ndarray, n_states: int = DEFAULT_STATES, max_iter: int = DEFAULT_MAX_ITER,
+            tol: float = DEFAULT_TOL, max_workers: Optional[int] = None) -> Dict[str, np.ndarray]:
+    """
+    Fit a Gaussian HMM to every column by Baum-Welch.
+
+    Args:
+        residuals: (T x P) spread residuals, one pair per column
+        n_states: Number of hidden states (2 or 3)
+        max_iter: EM iteration limit
+        tol: Convergence threshold on each pair's mean log-likelihood per observation
+        max_workers: Thread count for pair chunks (default: DEFAULT_WORKERS,
+            at most the CPU count); each holds one chunk's working arrays
+
+    Returns:
+        Dictionary with 'start' (P, K), 'transition' (P, K, K), 'mean' and
+        'var' (P, K), 'state_prob' (P, K) filtered at the last bar, 'loglik'
+        and 'iterations' (P,) per pair; state 0 has the smallest variance
+    """
+    obs = np.asarray(residuals, dtype=float)
+    if obs.ndim == 1:
+        obs = obs[:, None]
+    num_steps, num_pairs = obs.shape
+    width = max(1, min(PAIR_CHUNK, STATE_CELLS // (num_steps * n_states)))
+    chunks = [slice(i, min(i + width, num_pairs)) for i in range(0, num_pairs, width)]
+    workers = max_workers or min(len(chunks), DEFAULT_WORKERS, os.cpu_count() or 1)
+
+    with ThreadPoolExecutor(max_workers=max(workers, 1)) as pool:
+        parts = list(pool.map(lambda c: _fit_chunk(obs[:, c], n_states, max_iter, tol), chunks))
+    return {key: np.concatenate([part[key] for part in parts]) for key in parts[0]}
+
+
+class RegimeFilter:
+    """
+    Streaming forward filter for fitted HMMs: one predict/update per bar.
+    """
+
+    def __init__(self, model: Dict[str, np.ndarray], scale: Optional[np.ndarray] = None):
+        """
+        Args:
+            model: Output of fit_hmm (state_prob seeds the filter)
+            scale: (P,) divisor the fitted residuals were standardized by
+                (default: none); update() applies it to raw residuals
+        """
+        self.scale = np.ones(len(model['mean'])) if scale is None else np.asarray(scale, dtype=float)
+        self.transition = model['transition']
+        self.mean = model['mean']
+        self.var = model['var']
+        self.state_prob = model['state_prob'].copy()
+
+    def update(self, observation: np.ndarray) -> np.ndarray:
+        """
+        Advance every pair by one bar.
+
+        Args:
+            observation: (P,) raw residuals of the new bar, in the units
+                before scaling (NaN leaves a pair's probabilities at the
+                one-step prediction)
+
+        Returns:
+            (P, K) filtered state probabilities
+        """
+        predicted = np.matmul(self.state_prob[:, None, :], self.transition)[:, 0, :]
+        obs = (np.asarray(observation, dtype=float) / self.scale)[:, None]
+        log_b = -0.5 * (np.log(2 * np.pi * self.var) + (obs - self.mean) ** 2 / self.var)
+        likelihood = np.exp(log_b - log_b.max(axis=1, keepdims=True))
+        posterior = predicted * np.where(np.isfinite(likelihood), likelihood, 1.0)
+        self.state_prob = posterior / posterior.sum(axis=1, keepdims=True)
+        return self.state_prob
+
+    def most_likely(self) -> np.ndarray:
+        return self.state_prob.argmax(axis=1)
@@ -0,0 +1,151 @@
+"""
+Result Cache - Content-addressed, size-bounded disk cache of per-pair tests
+
+Each symbol's aligned window (timestamps and closes) is fingerprinted once
+with BLAKE2b; a pair's key hashes the two fingerprints with the test
+parameters. Identical data therefore hits regardless of where it came from
+(repeated example runs, overlapping universes), and any change to a window
+(new bars, a shifted start) produces a new key instead of a stale hit.
+
+Entries are small JSON files named by their key. Least-recently-used entries
+are evicted once the directory exceeds its byte budget; hits refresh the
+file's modification time, which also orders entries across processes.
+"""
+
+import hashlib
+import json
+import os
+import tempfile
+import threading
+from collections import OrderedDict
+from typing import Dict, Optional
+
+import numpy as np
+
+DEFAULT_CACHE_DIR = '.statarb_cache'
+DEFAULT_MAX_BYTES = 256 * 1024 * 1024
+
+# Bumped when the stored fields or their meaning change
+CACHE_FORMAT = 1
+
+DIGEST_SIZE = 20
+
+
+def fingerprint(values: np.ndarray, timestamps: Optional[np.ndarray] = None) -> str:
+    """
+    BLAKE2b digest of a series' values (as float64) and optional int64 timestamps.
+    """
+    h = hashlib.blake2b(digest_size=DIGEST_SIZE)
+    h.update(np.ascontiguousarray(values, dtype=np.float64).tobytes())
+    if timestamps is not None:
+        h.update(np.ascontiguousarray(timestamps).view(np.int64).tobytes())
+    return h.hexdigest()
+
+
+class PairResultCache:
+    """
+    Disk LRU of per-pair results keyed by content.
+    """
+
+    def __init__(self, directory: str = DEFAULT_CACHE_DIR, max_bytes: int = DEFAULT_MAX_BYTES):
+        """
+        Args:
+            directory: Cache directory (created if missing)
+            max_bytes: Total size budget for cached entries
+        """
+        self.directory = directory
+        self.max_bytes = max_bytes
+        self.hits = 0
+        self.misses = 0
+        self._lock = threading.Lock()
+        os.makedirs(directory, exist_ok=True)
+
+        # key -> size, oldest first
+        entries = []
+        for entry in os.scandir(directory):
+            if entry.is_file() and entry.name.endswith('.json'):
+                stat = entry.stat()
+                entries.append((stat.st_mtime, entry.name[:-5], stat.st_size))
+        self._index = OrderedDict((key, size) for _, key, size in sorted(entries))
+        self._bytes = sum(self._index.values())
+
+    def pair_key(self, fingerprint1: str, fingerprint2: str, params: Dict) -> str:
+        """
+        Key of an ordered pair's result under the given test parameters.
+        """
+        h = hashlib.blake2b(digest_size=DIGEST_SIZE)
+        h.update(f"v{CACHE_FORMAT}|{fingerprint1}|{fingerprint2}|".encode())
+        h.update(json.dumps(params, sort_keys=True).encode())
+        return h.hexdigest()
+
+    def _path(self, key: str) -> str:
+        return os.path.join(self.directory, key + '.json')
+
+    def get(self, key: str) -> Optional[Dict]:
+        """
+        Cached value, or None; a hit marks the entry most recently used.
+        """
+        path = self._path(key)
+        try:
+            with open(path) as f:
+                value = json.load(f)
+            os.utime(path)
+        except (OSError, ValueError):
+            with self._lock:
+                self.misses += 1
+                if key in self._index:
+                    self._bytes -= self._index.pop(key)
+            return None
+
+        with self._lock:
+            self.hits += 1
+            if key in self._index:
+                self._index.move_to_end(key)
+            else:
+                # Written by another process sharing the directory
+                size = os.path.getsize(path)
+                self._index[key] = size
+                self._bytes += size
+        return value
+
+    def put(self, key: str, value: Dict):
+        """
+        Store a JSON-serializable value (written atomically), then evict to budget.
+        """
+        data = json.dumps(value, default=float).encode()
+        fd, tmp_path = tempfile.mkstemp(dir=self.directory, suffix='.tmp')
+        with os.fdopen(fd, 'wb') as f:
+            f.write(data)
+        os.replace(tmp_path, self._path(key))
+
+        with self._lock:
+            self._bytes -= self._index.pop(key, 0)
+            self._index[key] = len(data)
+            self._bytes += len(data)
+            self._evict()
+
+    def _evict(self):
+        while self._bytes > self.max_bytes and len(self._index) > 1:
+            key, size = self._index.popitem(last=False)
+            self._bytes -= size
+            try:
+                os.remove(self._path(key))
+            except OSError:
+                pass
+
+    def clear(self):
+        with self._lock:
+            for key in list(self._index):
+                try:
+                    os.remove(self._path(key))
+                except OSError:
+                    pass
+            self._index.clear()
+            self._bytes = 0
+
+    @property
+    def size_bytes(self) -> int:
+        return self._bytes
+
+    def __len__(self) -> int:
+        return len(self._index)
@@ -0,0 +1,144 @@
+"""
+Results Snapshot - Versioned, immutable results tables for concurrent readers
+
+A scan publishes its ranked pairs as a ResultsSnapshot: read-only column
+arrays plus a version number. The publisher holds one reference to the
+current snapshot and replaces it with a single assignment, so:
+
+- readers call current() and get a consistent table without locks (a
+  reference read is atomic), and keep using it for as long as they like
+- writers build the next snapshot off to the side and never wait for readers
+- an old snapshot is freed when its last reader drops it; reference counting
+  does the job epoch-based reclamation does for native RCU
+"""
+
+import threading
+import time
+import weakref
+import numpy as np
+import pandas as pd
+from typing import Dict, List, Optional
+
+
+class ResultsSnapshot:
+    """
+    Immutable results table: one read-only numpy array per column.
+    """
+
+    __slots__ = ('version', 'published_at', 'columns', '_arrays', '_row_index', '__weakref__')
+
+    def __init__(self, version: int, frame: pd.DataFrame, key_column: str = 'pair'):
+        """
+        Args:
+            version: Monotonic version assigned by the publisher
+            frame: Table to freeze; its values are copied
+            key_column: Column used for row lookups
+        """
+        self.version = version
+        self.published_at = time.time()
+        self.columns = tuple(frame.columns)
+
+        arrays = {}
+        for column in self.columns:
+            values = np.array(frame[column].to_numpy(), copy=True)
+            values.setflags(write=False)
+            arrays[column] = values
+        self._arrays = arrays
+
+        keys = arrays.get(key_column)
+        self._row_index = {key: i for i, key in enumerate(keys)} if keys is not None else {}
+
+    def __len__(self) -> int:
+        return len(next(iter(self._arrays.values()))) if self._arrays else 0
+
+    def column(self, name: str) -> np.ndarray:
+        """
+        Read-only view of one column.
+        """
+        return self._arrays[name]
+
+    def row(self, key: str) -> Optional[Dict]:
+        """
+        One row as a dictionary, looked up by the key column (e.g. 'EURUSD/USDCHF').
+        """
+        i = self._row_index.get(key)
+        if i is None:
+            return None
+        return {column: values[i] for column, values in self._arrays.items()}
+
+    def top(self, k: int) -> List[Dict]:
+        """
+        First k rows in published (ranked) order.
+        """
+        return [{column: values[i] for column, values in self._arrays.items()}
+                for i in range(min(k, len(self)))]
+
+    def to_dataframe(self) -> pd.DataFrame:
+        """
+        Writable copy of the table.
+        """
+        return pd.DataFrame({column: values.copy() for column, values in self._arrays.items()})
+
+
+class ResultsPublisher:
+    """
+    Holds the current ResultsSnapshot and swaps in new versions.
+    """
+
+    def __init__(self, key_column: str = 'pair'):
+        self.key_column = key_column
+        self._current = ResultsSnapshot(0, pd.DataFrame(), key_column)
+        self._writer_lock = threading.Lock()
+        self._updated = threading.Condition(threading.Lock())
+        self._live = weakref.WeakValueDictionary()
+
+    def current(self) -> ResultsSnapshot:
+        """
+        Latest published snapshot (wait-free; never blocks on writers).
+        """
+        return self._current
+
+    @property
+    def version(self) -> int:
+        return self._current.version
+
+    def publish(self, table) -> ResultsSnapshot:
+        """
+        Freeze a table and make it the current snapshot.
+
+        The snapshot is built before the swap, so readers see either the old
+        or the new version in full and never wait.
+
+        Args:
+            table: DataFrame, or an iterable of row dictionaries
+
+        Returns:
+            The published snapshot
+        """
+        frame = table if isinstance(table, pd.DataFrame) else pd.DataFrame(list(table))
+        snapshot = ResultsSnapshot(0, frame, self.key_column)
+
+        # Writers serialize only for the version number and the swap
+        with self._writer_lock:
+            snapshot.version = self._current.version + 1
+            self._current = snapshot
+            self._live[snapshot.version] = snapshot
+
+        with self._updated:
+            self._updated.notify_all()
+        return snapshot
+
+    def wait_for_update(self, after_version: int, timeout: Optional[float] = None) -> ResultsSnapshot:
+        """
+        Block until a version newer than after_version is published (for
+        readers that poll, e.g. dashboards), or until the timeout.
+        """
+        with self._updated:
+            self._updated.wait_for(lambda: self._current.version > after_version, timeout)
+        return self._current
+
+    def live_versions(self) -> List[int]:
+        """
+        Versions still referenced by someone (current plus any held by readers).
+        """
+        return sorted(self._live.keys())
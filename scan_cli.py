@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""
+Scan CLI - Headless correlate -> cointegrate -> rank over a columnar store
+
+Meant for cron: it reads the symbol lists and ANALYSIS_CONFIG from a config
+file (config.py or JSON), maps the store written by
+StatisticalArbitrageAnalyzer.save_columnar_store(), and writes ranked pairs
+to CSV. Only numpy and the numpy engines are imported (lazily, after the
+arguments parse); matplotlib, seaborn, sklearn, statsmodels and pandas are
+never loaded.
+
+Cointegration uses the moment-based zero-lag Engle-Granger test of
+cointegration_engine (coint() with maxlag=0), so p-values can differ
+slightly from the analyzer's statsmodels coint(), which selects
+augmentation lags by AIC.
+
+Usage:
+    python scan_cli.py --store data/universe --config config.py --output pairs.csv
+"""
+
+import argparse
+import sys
+import time
+
+# Same weights as the analyzer's DEFAULT_SCORE_WEIGHTS
+SCORE_WEIGHTS = {
+    'p_value': 0.4,
+    'r_squared': 0.3,
+    'correlation': 0.2,
+    'residual_std': 0.1,
+}
+
+OUTPUT_COLUMNS = [
+    'pair', 'symbol1', 'symbol2', 'composite_score',
+    'p_value', 'cointegration_stat', 'hedge_ratio',
+    'r_squared', 'correlation', 'residual_std',
+    'critical_value_5%', 'intercept',
+]
+
+DEFAULT_ANALYSIS_CONFIG = {
+    'lookback_days': 90,
+    'cointegration_pvalue_threshold': 0.05,
+    'correlation_threshold': 0.7,
+    'min_observations': 1000,
+}
+
+
+def load_config(path: str) -> dict:
+    """
+    Read a config module (.py, executed in isolation) or a JSON file.
+
+    Returns:
+        Dictionary with 'symbols' (deduplicated, in file order, from every
+        top-level list of strings) and 'analysis' (ANALYSIS_CONFIG merged
+        over the defaults)
+    """
+    if path.endswith('.json'):
+        import json
+        with open(path) as f:
+            namespace = json.load(f)
+    else:
+        import runpy
+        namespace = runpy.run_path(path)
+
+    symbols = []
+    for name, value in namespace.items():
+        if name.isupper() and isinstance(value, list) and value and all(isinstance(v, str) for v in value):
+            symbols.extend(s for s in value if s not in symbols)
+
+    analysis = dict(DEFAULT_ANALYSIS_CONFIG)
+    analysis.update(namespace.get('ANALYSIS_CONFIG', {}))
+    return {'symbols': symbols, 'analysis': analysis}
+
+
+def rank_pairs(closes, symbols, correlation, stats, significance_level, min_correlation):
+    """
+    Cointegrated pairs (symbol1 regressed on symbol2, i < j) with composite scores.
+
+    Returns:
+        List of result dictionaries, best composite score first
+    """
+    import numpy as np
+
+    var = closes.var(axis=0)
+    rows, cols = np.triu_indices(len(symbols), k=1)
+    p_value = stats['p_value'][rows, cols]
+    corr = correlation[rows, cols]
+
+    keep = np.isfinite(p_value) & (p_value < significance_level) & (np.abs(corr) >= min_correlation)
+    rows, cols, p_value, corr = rows[keep], cols[keep], p_value[keep], corr[keep]
+
+    beta = stats['hedge_ratio'][rows, cols]
+    r_squared = corr ** 2
+    residual_std = np.sqrt(np.maximum(var[rows] * (1 - r_squared), 0))
+    intercept = stats['intercept'][rows, cols]
+    score = (SCORE_WEIGHTS['p_value'] * (1 - p_value)
+             + SCORE_WEIGHTS['r_squared'] * r_squared
+             + SCORE_WEIGHTS['correlation'] * np.abs(corr)
+             + SCORE_WEIGHTS['residual_std'] / (1 + residual_std))
+    critical_5 = stats['critical_values'][1]
+
+    results = []
+    for k in np.argsort(-score, kind='stable'):
+        i, j = rows[k], cols[k]
+        results.append({
+            'pair': f"{symbols[i]}/{symbols[j]}",
+            'symbol1': symbols[i],
+            'symbol2': symbols[j],
+            'composite_score': score[k],
+            'p_value': p_value[k],
+            'cointegration_stat': stats['df_stat'][i, j],
+            'hedge_ratio': beta[k],
+            'r_squared': r_squared[k],
+            'correlation': corr[k],
+            'residual_std': residual_std[k],
+            'critical_value_5%': critical_5,
+            'intercept': intercept[k],
+        })
+    return results
+
+
+def write_csv(path: str, results):
+    """
+    Write ranked pairs with the analyzer's column order, floats rounded to 6 places.
+    """
+    import csv
+    with open(path, 'w', newline='') as f:
+        writer = csv.writer(f)
+        writer.writerow(OUTPUT_COLUMNS)
+        for r in results:
+            writer.writerow([round(float(r[c]), 6) if not isinstance(r[c], str) else r[c]
+                             for c in OUTPUT_COLUMNS])
+
+
+def parse_args(argv=None):
+    parser = argparse.ArgumentParser(description="Headless cointegrated pair scan over a columnar store")
+    parser.add_argument('--store', required=True, help="Columnar store directory")
+    parser.add_argument('--config', default='config.py', help="config.py-style module or JSON file")
+    parser.add_argument('--output', default='cointegrated_pairs.csv', help="Output CSV")
+    parser.add_argument('--all-symbols', action='store_true',
+                        help="Scan every symbol in the store instead of the config lists")
+    parser.add_argument('--significance', type=float, help="Override cointegration_pvalue_threshold")
+    parser.add_argument('--min-correlation', type=float, default=0.0,
+                        help="Only report pairs with |correlation| at least this (default: all)")
+    parser.add_argument('--quiet', action='store_true', help="Only print errors")
+    return parser.parse_args(argv)
+
+
+def main(argv=None) -> int:
+    started = time.perf_counter()
+    args = parse_args(argv)
+    log = (lambda *a: None) if args.quiet else print
+
+    config = load_config(args.config)
+    analysis = config['analysis']
+    significance = args.significance if args.significance is not None else analysis['cointegration_pvalue_threshold']
+
+    # Selects the SIMD tier for numpy/OpenBLAS kernels; must be imported before numpy
+    import kernel_dispatch  # noqa: F401
+    from columnar_store import load_store
+    from correlation_engine import scan_correlations
+    from cointegration_engine import multi_frequency_cointegration
+
+    timestamps, closes, symbols = load_store(
+        args.store, symbols=None if args.all_symbols else config['symbols'],
+        lookback_days=analysis.get('lookback_days'))
+    log(f"⏱️  Startup {1000 * (time.perf_counter() - started):.0f} ms; "
+        f"{closes.shape[0]} bars x {len(symbols)} symbols")
+
+    if len(symbols) < 2:
+        print(f"❌ Not enough configured symbols in {args.store} ({len(symbols)} found)", file=sys.stderr)
+        return 1
+    if closes.shape[0] < analysis['min_observations']:
+        print(f"❌ Only {closes.shape[0]} bars; min_observations is {analysis['min_observations']}",
+              file=sys.stderr)
+        return 1
+
+    step = time.perf_counter()
+    matrix, _ = scan_correlations(closes, symbols)
+    correlation = matrix.to_dense()
+    log(f"📊 Correlations in {time.perf_counter() - step:.2f}s")
+
+    step = time.perf_counter()
+    stats = multi_frequency_cointegration(closes, strides=(1,))[1]
+    log(f"🔬 Engle-Granger for {len(symbols) * (len(symbols) - 1) // 2} pairs "
+        f"in {time.perf_counter() - step:.2f}s")
+
+    results = rank_pairs(closes, symbols, correlation, stats, significance, args.min_correlation)
+    write_csv(args.output, results)
+    log(f"💾 {len(results)} cointegrated pairs saved to {args.output} "
+        f"({time.perf_counter() - started:.2f}s total)")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,151 @@
+"""
+Scan Scheduler - Priority ordering, best-so-far tracking and deadline bounds
+
+The per-pair Engle-Granger test is the expensive step of a scan. Visiting
+pairs in order of a cheap prior (level correlation, normalized-price
+distance, or the previous scan's rank) makes good pairs appear early, so a
+scan stopped by a wall-clock deadline still returns the pairs that matter.
+The pairs left untested are summarized by a binomial bound on how many
+cointegrated pairs they could hold.
+"""
+
+import heapq
+import itertools
+import numpy as np
+from scipy import stats
+from typing import Dict, List, Optional, Sequence, Tuple
+
+PRIORITIES = ('correlation', 'distance', 'previous', 'none')
+
+# Lowest-priority tested pairs used to estimate the hit rate among skipped ones
+TAIL_SAMPLE = 50
+
+
+def pair_priors(prices: np.ndarray, method: str = 'correlation',
+                previous_rank: Optional[Dict[Tuple[int, int], int]] = None) -> np.ndarray:
+    """
+    Prior score (higher = test earlier) for every pair i < j.
+
+    Args:
+        prices: (T x N) aligned close matrix
+        method: 'correlation' (|corr| of levels), 'distance' (negative sum of
+            squared differences of prices normalized to start at 1, as in
+            the distance method of pair selection), 'previous' (rank in the
+            previous scan, then correlation) or 'none' (combinations order)
+        previous_rank: (i, j) -> rank from the previous scan, for 'previous'
+
+    Returns:
+        (N, N) array; only the upper triangle is meaningful
+    """
+    if method not in PRIORITIES:
+        raise ValueError(f"Unknown scan priority '{method}'; expected one of {', '.join(PRIORITIES)}")
+
+    num_symbols = prices.shape[1]
+    if method == 'none':
+        # Descending scores that reproduce combinations() order
+        order = np.zeros((num_symbols, num_symbols))
+        for k, (i, j) in enumerate(itertools.combinations(range(num_symbols), 2)):
+            order[i, j] = -k
+        return order
+
+    if method == 'distance':
+        normalized = prices / prices[0]
+        gram = normalized.T @ normalized
+        sq = np.diag(gram)
+        return -(sq[:, None] + sq[None, :] - 2 * gram)
+
+    with np.errstate(divide='ignore', invalid='ignore'):
+        scores = np.nan_to_num(np.abs(np.corrcoef(prices, rowvar=False)))
+
+    if method == 'previous' and previous_rank:
+        # Previously ranked pairs first (best rank first), the rest by correlation
+        offset = len(previous_rank) + 1
+        for (i, j), rank in previous_rank.items():
+            scores[min(i, j), max(i, j)] = offset + (len(previous_rank) - rank)
+
+    return scores
+
+
+def priority_order(priors: np.ndarray) -> List[Tuple[int, int]]:
+    """
+    Pairs i < j sorted by descending prior (stable for ties).
+    """
+    rows, cols = np.triu_indices(priors.shape[0], k=1)
+    order = np.argsort(-priors[rows, cols], kind='stable')
+    return list(zip(rows[order].tolist(), cols[order].tolist()))
+
+
+class AnytimeTopK:
+    """
+    Best-so-far K results by ascending key (p-value by default).
+    """
+
+    def __init__(self, k: int, key: str = 'p_value'):
+        self.k = k
+        self.key = key
+        self._heap = []          # max-heap on key via negation
+        self._counter = itertools.count()
+
+    def push(self, result: Dict) -> bool:
+        """
+        Offer a result; returns True if it entered the top K.
+        """
+        value = result.get(self.key)
+        if value is None or not np.isfinite(value):
+            return False
+        entry = (-value, next(self._counter), result)
+        if len(self._heap) < self.k:
+            heapq.heappush(self._heap, entry)
+            return True
+        if -self._heap[0][0] > value:
+            heapq.heapreplace(self._heap, entry)
+            return True
+        return False
+
+    def items(self) -> List[Dict]:
+        """
+        Current top K, best first.
+        """
+        return [entry[2] for entry in sorted(self._heap, key=lambda e: (-e[0], e[1]))]
+
+
+def skipped_pair_bounds(tested_hits: Sequence[bool], num_skipped: int,
+                        confidence: float = 0.95,
+                        tail_sample: int = TAIL_SAMPLE) -> Dict[str, float]:
+    """
+    Estimate how many cointegrated pairs the untested pairs may contain.
+
+    Pairs are tested in descending prior order, so the skipped pairs rank
+    below the last tested ones. The cointegration rate among the last
+    `tail_sample` tested pairs, with a one-sided Clopper-Pearson upper
+    limit, bounds the rate among the skipped pairs (assuming the prior is
+    informative, i.e. the rate does not rise as the prior falls).
+
+    Args:
+        tested_hits: is_cointegrated flags in test order
+        num_skipped: Number of pairs never tested
+        confidence: Confidence level of the upper limit
+        tail_sample: Trailing tested pairs used for the rate
+
+    Returns:
+        Dictionary with 'skipped', 'tail_rate', 'expected_missed' and
+        'missed_upper' (upper confidence limit on cointegrated pairs skipped)
+    """
+    tail = list(tested_hits)[-tail_sample:]
+    n, hits = len(tail), int(sum(tail))
+
+    if num_skipped == 0:
+        return {'skipped': 0, 'tail_rate': hits / n if n else np.nan,
+                'expected_missed': 0.0, 'missed_upper': 0.0}
+    if n == 0:
+        return {'skipped': num_skipped, 'tail_rate': np.nan,
+                'expected_missed': np.nan, 'missed_upper': float(num_skipped)}
+
+    rate = hits / n
+    upper = 1.0 if hits == n else stats.beta.ppf(confidence, hits + 1, n - hits)
+    return {
+        'skipped': num_skipped,
+        'tail_rate': rate,
+        'expected_missed': rate * num_skipped,
+        'missed_upper': upper * num_skipped,
+    }
@@ -0,0 +1,220 @@
+"""
+Signal Backtest - Vectorized entry/exit/stop simulation for candidate pairs
+
+Approximates the cBot's trading rules for every pair in one pass so pairs
+can be ranked by tradability before an event-driven replay. Rolling
+z-scores come from prefix sums, and the position state machine steps
+through time once with every pair's state held in (P,) arrays, so each bar
+is a few masked array updates and no per-pair branching. PnL is measured in
+spread units (price of symbol1 minus hedge ratio times symbol2).
+
+Differences from StatArbStrategy in cbot/StatArbStrategy.cs:
+
+- The z-stop (stop_z) is not a bot rule; it is off by default and is meant
+  for STRATEGY_CONFIG['stop_loss_zscore'].
+- max_hold counts bars, while the bot's MaxTradeDurationMinutes counts wall
+  time (equal on gap-free M1 bars).
+- Signals and PnL use bar closes rather than tick mids, with no spread
+  filter, sizing, costs or slippage.
+"""
+
+import os
+import numpy as np
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, Optional
+
+# Minimum pair columns per simulation batch; batches are widened so each
+# worker gets one, since the per-bar loop cost is mostly fixed overhead
+PAIR_CHUNK = 256
+
+# Bars per block of precomputed z-scores; bounds temporaries to TIME_BLOCK x P
+TIME_BLOCK = 4096
+
+# Window, thresholds and hold match StatArbSettings defaults (hold in M1 bars);
+# the bot has no z-stop
+DEFAULT_WINDOW = 50
+DEFAULT_ENTRY_Z = 2.0
+DEFAULT_EXIT_Z = 0.5
+DEFAULT_STOP_Z = np.inf
+DEFAULT_MAX_HOLD_BARS = 30
+
+
+def rolling_zscores(spreads: np.ndarray, window: int) -> np.ndarray:
+    """
+    Z-score of each bar against the trailing window that includes it.
+
+    Uses prefix sums of the (column-shifted) spread and its square, and the
+    sample standard deviation, like RollingWindow in the cBot.
+
+    Args:
+        spreads: (T x P) spread matrix
+        window: Rolling window length in bars
+
+    Returns:
+        (T x P) z-scores; NaN during warm-up and where the window is flat
+    """
+    num_obs = spreads.shape[0]
+    z = np.full(spreads.shape, np.nan)
+    if num_obs < window or window < 2:
+        return z
+
+    shifted = spreads - spreads[0]
+    zero = np.zeros((1, spreads.shape[1]))
+    csum = np.concatenate([zero, np.cumsum(shifted, axis=0)])
+    csq = np.concatenate([zero, np.cumsum(shifted * shifted, axis=0)])
+
+    total = csum[window:] - csum[:-window]
+    total_sq = csq[window:] - csq[:-window]
+    mean = total / window
+    var = np.maximum((total_sq - total * mean) / (window - 1), 0.0)
+
+    with np.errstate(divide='ignore', invalid='ignore'):
+        z[window - 1:] = (shifted[window - 1:] - mean) / np.sqrt(var)
+    z[window - 1:][var <= 0] = np.nan
+    return z
+
+
+def _simulate_chunk(spreads: np.ndarray, window: int, entry_z: float, exit_z: float,
+                    stop_z: float, max_hold: int) -> Dict[str, np.ndarray]:
+    """
+    Step the entry/exit/stop state machine through time for a chunk of pairs.
+
+    position is +1 (long spread), -1 (short spread) or 0. After max_hold bars
+    a losing trade is closed; a winning one gets a stop at its current PnL
+    and is closed when PnL falls back through it (the cBot's stop at market).
+
+    Z-scores and threshold masks are computed per block of TIME_BLOCK bars
+    (with window - 1 bars of overlap), so the per-bar loop only combines
+    precomputed boolean rows with the position state.
+    """
+    num_obs, num_pairs = spreads.shape
+    position = np.zeros(num_pairs)
+    entry_spread = np.zeros(num_pairs)
+    entry_bar = np.zeros(num_pairs, dtype=np.int64)
+    trail = np.full(num_pairs, -np.inf)
+
+    pnl = np.zeros(num_pairs)
+    trades = np.zeros(num_pairs, dtype=np.int64)
+    wins = np.zeros(num_pairs, dtype=np.int64)
+    stops = np.zeros(num_pairs, dtype=np.int64)
+    bars_in_market = np.zeros(num_pairs, dtype=np.int64)
+
+    for block_start in range(0, num_obs, TIME_BLOCK):
+        block_stop = min(block_start + TIME_BLOCK, num_obs)
+        history = max(block_start - window + 1, 0)
+        z = rolling_zscores(spreads[history:block_stop], window)[block_start - history:]
+
+        # NaN z-scores (warm-up, flat windows) fail every comparison
+        with np.errstate(invalid='ignore'):
+            in_exit = np.abs(z) <= exit_z
+            enter_long = (z < -entry_z) & (z > -stop_z)
+            enter_short = (z > entry_z) & (z < stop_z)
+            adverse_long = z <= -stop_z
+            adverse_short = z >= stop_z
+
+        for row, t in enumerate(range(block_start, block_stop)):
+            st = spreads[t]
+            long_ = position > 0
+            short_ = position < 0
+            open_ = long_ | short_
+            trade_pnl = position * (st - entry_spread)
+
+            # Exits: reversion into the exit band, z-stop, time rule
+            timed = open_ & (t - entry_bar >= max_hold)
+            arm = timed & (trade_pnl >= 0) & np.isneginf(trail)
+            trail[arm] = trade_pnl[arm]
+            stopped = (long_ & adverse_long[row]) | (short_ & adverse_short[row])
+            close = (open_ & (in_exit[row] | (trade_pnl < trail))) | stopped | (timed & (trade_pnl < 0))
+
+            if close.any():
+                closed_pnl = trade_pnl[close]
+                pnl[close] += closed_pnl
+                trades[close] += 1
+                wins[close] += closed_pnl > 0
+                stops += stopped
+                position[close] = 0.0
+                trail[close] = -np.inf
+            bars_in_market += open_ & ~close
+
+            # Entries only for pairs that were flat before this bar
+            flat = ~open_
+            go_long = flat & enter_long[row]
+            go_short = flat & enter_short[row]
+            enter = go_long | go_short
+            if enter.any():
+                position[go_long] = 1.0
+                position[go_short] = -1.0
+                entry_spread[enter] = st[enter]
+                entry_bar[enter] = t
+
+    # Mark any open trade to the last bar
+    final = position * (spreads[-1] - entry_spread)
+    still_open = position != 0
+    pnl += np.where(still_open, final, 0.0)
+    trades += still_open
+    wins += still_open & (final > 0)
+
+    return {
+        'pnl': pnl,
+        'trades': trades,
+        'wins': wins,
+        'stops': stops,
+        'bars_in_market': bars_in_market,
+    }
+
+
+def backtest_spreads(spreads: np.ndarray, window: int = DEFAULT_WINDOW,
+                     entry_z: float = DEFAULT_ENTRY_Z, exit_z: float = DEFAULT_EXIT_Z,
+                     stop_z: float = DEFAULT_STOP_Z, max_hold: int = DEFAULT_MAX_HOLD_BARS,
+                     max_workers: Optional[int] = None) -> Dict[str, np.ndarray]:
+    """
+    Approximate PnL and trade statistics for many spreads at once.
+
+    Args:
+        spreads: (T x P) spread matrix, one column per pair
+        window: Rolling z-score window in bars
+        entry_z: |z| above which a trade is opened against the deviation
+        exit_z: |z| at or below which an open trade is closed
+        stop_z: |z| against the position at which the trade is stopped out
+            (and above which no trade is opened); inf disables it, as in the bot
+        max_hold: Bars after which the time-based exit rule applies
+        max_workers: Thread pool size (defaults to the CPU count)
+
+    Returns:
+        Dictionary of (P,) arrays: 'pnl' (spread units), 'pnl_sigma' (pnl
+        divided by the spread's standard deviation), 'trades', 'win_rate',
+        'stops' and 'time_in_market' (fraction of bars with a position)
+    """
+    spreads = np.asarray(spreads, dtype=float)
+    if spreads.ndim == 1:
+        spreads = spreads[:, None]
+
+    num_obs, num_pairs = spreads.shape
+    workers = max_workers or os.cpu_count() or 1
+    width = max(PAIR_CHUNK, -(-num_pairs // workers))
+    chunks = [slice(start, start + width) for start in range(0, num_pairs, width)]
+
+    def run(cols: slice) -> Dict[str, np.ndarray]:
+        return _simulate_chunk(spreads[:, cols], window, entry_z, exit_z, stop_z, max_hold)
+
+    if workers > 1 and len(chunks) > 1:
+        with ThreadPoolExecutor(max_workers=min(workers, len(chunks))) as pool:
+            parts = list(pool.map(run, chunks))
+    else:
+        parts = [run(cols) for cols in chunks]
+
+    if not parts:
+        return {}
+
+    raw = {key: np.concatenate([part[key] for part in parts]) for key in parts[0]}
+    spread_std = spreads.std(axis=0)
+
+    with np.errstate(divide='ignore', invalid='ignore'):
+        return {
+            'pnl': raw['pnl'],
+            'pnl_sigma': np.where(spread_std > 0, raw['pnl'] / spread_std, np.nan),
+            'trades': raw['trades'],
+            'win_rate': np.where(raw['trades'] > 0, raw['wins'] / raw['trades'], np.nan),
+            'stops': raw['stops'],
+            'time_in_market': raw['bars_in_market'] / max(num_obs, 1),
+        }
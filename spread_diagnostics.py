@@ -0,0 +1,299 @@
+"""
+Spread Diagnostics - Batched mean-reversion statistics for candidate pairs
+
+All functions operate column-wise on (T x P) arrays, where each column is one
+pair, so every candidate pair is handled in a single vectorized pass
+instead of a Python loop per pair.
+"""
+
+import os
+import numpy as np
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, Optional, Sequence, Tuple
+
+# Number of pair columns processed at once; bounds the temporary arrays
+# to roughly T * PAIR_CHUNK float64 values.
+PAIR_CHUNK = 64
+
+# Lo-MacKinlay variance-ratio horizons (in bars)
+DEFAULT_VR_HORIZONS = (2, 4, 8, 16)
+
+# Number of log-spaced DFA window sizes between MIN_DFA_WINDOW and T / 4
+DFA_SCALES = 10
+MIN_DFA_WINDOW = 16
+
+
+def pair_residuals(y: np.ndarray, x: np.ndarray, hedge_ratios: np.ndarray,
+                   intercepts: np.ndarray) -> np.ndarray:
+    """
+    Rebuild Engle-Granger residuals for a batch of pairs.
+
+    Args:
+        y: (T x P) dependent price series
+        x: (T x P) independent price series
+        hedge_ratios: (P,) OLS slopes from the cointegration test
+        intercepts: (P,) OLS intercepts from the cointegration test
+
+    Returns:
+        (T x P) residual matrix y - (beta * x + alpha)
+    """
+    return y - (x * hedge_ratios + intercepts)
+
+
+def ou_half_life(residuals: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Fit an AR(1)/OU model to each residual column.
+
+    Regresses de(t) = c + b * e(t-1) and converts the slope to an
+    Ornstein-Uhlenbeck half-life: -ln(2) / ln(1 + b).
+
+    Args:
+        residuals: (T x P) spread residuals
+
+    Returns:
+        Tuple of (half_life, ar_coefficient), each of shape (P,).
+        Half-life is in bars and is +inf for non mean-reverting spreads.
+    """
+    lagged = residuals[:-1]
+    delta = residuals[1:] - lagged
+
+    lag_dev = lagged - lagged.mean(axis=0)
+    var_lag = np.einsum('ij,ij->j', lag_dev, lag_dev)
+    cov = np.einsum('ij,ij->j', lag_dev, delta - delta.mean(axis=0))
+
+    with np.errstate(divide='ignore', invalid='ignore'):
+        b = np.where(var_lag > 0, cov / var_lag, 0.0)
+        phi = 1.0 + b
+        half_life = np.where((phi > 0) & (phi < 1), -np.log(2) / np.log(phi), np.inf)
+
+    return half_life, phi
+
+
+def ecm_adjustment_speed(y: np.ndarray, x: np.ndarray,
+                         residuals: np.ndarray) -> np.ndarray:
+    """
+    Estimate the error-correction speed of each pair.
+
+    Fits dy(t) = c + alpha * e(t-1) + gamma * dx(t) column-wise by solving
+    the 2x2 normal equations on demeaned moments. A negative alpha means the
+    dependent leg pulls back toward the long-run relationship.
+
+    Args:
+        y: (T x P) dependent price series
+        x: (T x P) independent price series
+        residuals: (T x P) Engle-Granger residuals
+
+    Returns:
+        (P,) array of ECM adjustment coefficients
+    """
+    dy = np.diff(y, axis=0)
+    dx = np.diff(x, axis=0)
+    e_lag = residuals[:-1]
+
+    dy = dy - dy.mean(axis=0)
+    dx = dx - dx.mean(axis=0)
+    e_lag = e_lag - e_lag.mean(axis=0)
+
+    s_ee = np.einsum('ij,ij->j', e_lag, e_lag)
+    s_xx = np.einsum('ij,ij->j', dx, dx)
+    s_ex = np.einsum('ij,ij->j', e_lag, dx)
+    s_ey = np.einsum('ij,ij->j', e_lag, dy)
+    s_xy = np.einsum('ij,ij->j', dx, dy)
+
+    det = s_ee * s_xx - s_ex ** 2
+    with np.errstate(divide='ignore', invalid='ignore'):
+        alpha = np.where(det > 0, (s_xx * s_ey - s_ex * s_xy) / det, np.nan)
+
+    return alpha
+
+
+def multiscale_grid(num_obs: int, vr_horizons: Sequence[int]) -> np.ndarray:
+    """
+    Build the shared scale grid used by the DFA and variance-ratio tests.
+
+    Args:
+        num_obs: Number of increments per series
+        vr_horizons: Variance-ratio horizons that must be part of the grid
+
+    Returns:
+        Sorted array of unique window sizes (in bars)
+    """
+    max_window = max(num_obs // 4, MIN_DFA_WINDOW)
+    dfa_windows = np.geomspace(MIN_DFA_WINDOW, max_window, DFA_SCALES)
+    grid = np.concatenate([np.asarray(vr_horizons), np.round(dfa_windows)])
+    return np.unique(grid.astype(int))
+
+
+def hurst_dfa(profile: np.ndarray, windows: np.ndarray) -> np.ndarray:
+    """
+    Estimate the Hurst exponent of each increment series with DFA-1.
+
+    The per-window linear detrending is computed from prefix sums of
+    y, t*y and y^2, which are built once and shared by every window size.
+
+    Args:
+        profile: (T x P) cumulative sum of demeaned increments
+        windows: Window sizes to evaluate (values above T / 2 are ignored)
+
+    Returns:
+        (P,) array of DFA scaling exponents (0.5 = random walk increments,
+        < 0.5 = anti-persistent / mean-reverting)
+    """
+    num_obs = profile.shape[0]
+    t = np.arange(num_obs, dtype=float)[:, None]
+
+    zeros = np.zeros((1, profile.shape[1]))
+    sum_y = np.vstack([zeros, np.cumsum(profile, axis=0)])
+    sum_ty = np.vstack([zeros, np.cumsum(t * profile, axis=0)])
+    sum_yy = np.vstack([zeros, np.cumsum(profile * profile, axis=0)])
+
+    log_n = []
+    log_f = []
+    for n in windows:
+        num_windows = num_obs // n
+        if n < 4 or num_windows < 2:
+            continue
+
+        starts = np.arange(num_windows) * n
+        ends = starts + n
+
+        s_y = sum_y[ends] - sum_y[starts]
+        s_ty = sum_ty[ends] - sum_ty[starts] - starts[:, None] * s_y
+        s_yy = sum_yy[ends] - sum_yy[starts]
+
+        t_mean = (n - 1) / 2.0
+        s_tt = n * (n * n - 1) / 12.0
+        s_cy = s_ty - t_mean * s_y
+
+        ssr = s_yy - s_y * s_y / n - s_cy * s_cy / s_tt
+        fluctuation = np.sqrt(np.maximum(ssr, 0).mean(axis=0) / n)
+
+        log_n.append(np.log(n))
+        log_f.append(np.log(np.maximum(fluctuation, 1e-300)))
+
+    if len(log_n) < 2:
+        return np.full(profile.shape[1], np.nan)
+
+    log_n = np.array(log_n)
+    log_f = np.array(log_f)
+    n_dev = log_n - log_n.mean()
+    return n_dev @ (log_f - log_f.mean(axis=0)) / (n_dev @ n_dev)
+
+
+def variance_ratios(residuals: np.ndarray, increments: np.ndarray,
+                    horizons: Sequence[int]) -> Dict[int, Tuple[np.ndarray, np.ndarray]]:
+    """
+    Lo-MacKinlay overlapping variance ratios with bias correction.
+
+    Args:
+        residuals: (T x P) spread levels
+        increments: (T-1 x P) one-bar changes of the spread
+        horizons: Horizons q (in bars) to test
+
+    Returns:
+        Mapping q -> (variance ratio, homoskedastic z-statistic), each (P,)
+    """
+    n = increments.shape[0]
+    mu = increments.mean(axis=0)
+    dev = increments - mu
+    var_1 = np.einsum('ij,ij->j', dev, dev) / (n - 1)
+
+    ratios = {}
+    for q in horizons:
+        if q < 2 or q >= n:
+            continue
+        q_changes = residuals[q:] - residuals[:-q] - q * mu
+        m = q * (n - q + 1) * (1 - q / n)
+        var_q = np.einsum('ij,ij->j', q_changes, q_changes) / m
+
+        with np.errstate(divide='ignore', invalid='ignore'):
+            vr = np.where(var_1 > 0, var_q / var_1, np.nan)
+        phi = 2 * (2 * q - 1) * (q - 1) / (3 * q * n)
+        ratios[q] = (vr, (vr - 1) / np.sqrt(phi))
+
+    return ratios
+
+
+def _diagnose_chunk(prices: np.ndarray, idx1: np.ndarray, idx2: np.ndarray,
+                    hedge_ratios: np.ndarray, intercepts: np.ndarray,
+                    vr_horizons: Sequence[int]) -> Dict[str, np.ndarray]:
+    """
+    Run every diagnostic for one chunk of pairs.
+
+    The residuals, their increments and the demeaned profile are built once
+    and shared by the OU, ECM, DFA and variance-ratio estimators.
+    """
+    y = prices[:, idx1]
+    x = prices[:, idx2]
+    residuals = pair_residuals(y, x, hedge_ratios, intercepts)
+
+    half_life, phi = ou_half_life(residuals)
+    stats = {
+        'half_life': half_life,
+        'ar_coefficient': phi,
+        'ecm_alpha': ecm_adjustment_speed(y, x, residuals),
+    }
+
+    increments = np.diff(residuals, axis=0)
+    profile = np.cumsum(increments - increments.mean(axis=0), axis=0)
+    grid = multiscale_grid(increments.shape[0], vr_horizons)
+
+    # DFA on the spread increments: H < 0.5 means the spread mean-reverts
+    stats['hurst'] = hurst_dfa(profile, grid)
+
+    for q, (vr, z) in variance_ratios(residuals, increments, vr_horizons).items():
+        stats[f'vr_{q}'] = vr
+        stats[f'vr_{q}_z'] = z
+
+    return stats
+
+
+def compute_spread_diagnostics(prices: np.ndarray, idx1: np.ndarray, idx2: np.ndarray,
+                               hedge_ratios: np.ndarray, intercepts: np.ndarray,
+                               vr_horizons: Sequence[int] = DEFAULT_VR_HORIZONS,
+                               max_workers: Optional[int] = None) -> Dict[str, np.ndarray]:
+    """
+    Compute all spread diagnostics for a batch of pairs.
+
+    Pairs are split into chunks of PAIR_CHUNK columns that run on a thread
+    pool; numpy releases the GIL inside the heavy reductions, so chunks
+    proceed in parallel while each chunk's temporaries stay bounded.
+
+    Args:
+        prices: (T x N) aligned close matrix
+        idx1: (P,) column index of the dependent symbol of each pair
+        idx2: (P,) column index of the independent symbol of each pair
+        hedge_ratios: (P,) OLS slopes
+        intercepts: (P,) OLS intercepts
+        vr_horizons: Variance-ratio horizons in bars
+        max_workers: Thread pool size (defaults to the CPU count)
+
+    Returns:
+        Dictionary of (P,) arrays: 'half_life', 'ar_coefficient', 'ecm_alpha',
+        'hurst', 'variance_ratio' (longest horizon) and 'vr_<q>' / 'vr_<q>_z'
+        for every horizon
+    """
+    num_pairs = len(idx1)
+    chunks = [slice(start, start + PAIR_CHUNK) for start in range(0, num_pairs, PAIR_CHUNK)]
+    workers = max_workers or os.cpu_count() or 1
+
+    def run(cols: slice) -> Dict[str, np.ndarray]:
+        return _diagnose_chunk(prices, idx1[cols], idx2[cols],
+                               hedge_ratios[cols], intercepts[cols], vr_horizons)
+
+    if workers > 1 and len(chunks) > 1:
+        with ThreadPoolExecutor(max_workers=min(workers, len(chunks))) as pool:
+            parts = list(pool.map(run, chunks))
+    else:
+        parts = [run(cols) for cols in chunks]
+
+    if not parts:
+        return {}
+
+    stats = {key: np.concatenate([part[key] for part in parts]) for key in parts[0]}
+
+    valid_horizons = [q for q in vr_horizons if f'vr_{q}' in stats]
+    if valid_horizons:
+        stats['variance_ratio'] = stats[f'vr_{max(valid_horizons)}']
+
+    return stats
@@ -9,6 +9,9 @@ Author: Abraham Kyendwa
 Date: 2025-06-18
 """
 
+# Selects the SIMD tier for numpy/OpenBLAS kernels; must be imported before numpy
+from kernel_dispatch import ACTIVE as KERNEL_VARIANT
+
 import pandas as pd
 import numpy as np
 import matplotlib.pyplot as plt
@@ -23,11 +26,35 @@ from statsmodels.tsa.stattools import coint
 from sklearn.linear_model import LinearRegression
 import scipy.stats as stats
 
+from spread_diagnostics import compute_spread_diagnostics
+from cointegration_engine import multi_frequency_cointegration
+from lead_lag import lead_lag_cross_correlation
+from robust_regression import robust_hedge_ratios
+from signal_backtest import backtest_spreads
+from memory_accounting import MEMORY
+from results_snapshot import ResultsPublisher
+from scan_scheduler import AnytimeTopK, pair_priors, priority_order, skipped_pair_bounds
+from result_cache import PairResultCache, fingerprint
+from columnar_store import write_store
+from portfolio_allocator import PortfolioAllocator, pair_returns, risk_contributions, shrunk_covariance
+from var_engine import IncrementalVaR
+from regime_hmm import RegimeFilter, fit_hmm
+from structural_breaks import DEFAULT_TRIM, gregory_hansen
+from fx_triangles import triangle_mispricing
+from heatmap_renderer import cluster_order, render_heatmap, render_pyramid
+from currency_factors import (currency_incidence, currency_strengths,
+                              cointegrated_currency_pairs, map_to_symbol_pairs)
+from pair_matrix import PairMatrix
+from correlation_engine import scan_correlations
+from correlation_graph import CorrelationGraph
+
 # For API connections (mock implementation included)
 import requests
 import json
 from typing import List, Dict, Tuple, Optional
+import threading
 import time
+import weakref
 
 class cTraderDataClient:
     """
@@ -37,6 +64,9 @@ class cTraderDataClient:
     the official cTrader Open API SDK or FIX API wrapper.
     """
     
+    # End of the mock timestamp grid, shared by every client in the process
+    _mock_end_time = None
+    
     def __init__(self, api_key: str = None, demo_mode: bool = True):
         """
         Initialize cTrader API client.
@@ -52,6 +82,13 @@ class cTraderDataClient:
         if not demo_mode and not api_key:
             raise ValueError("API key required for live data access")
     
+    @property
+    def source_key(self) -> Tuple:
+        """
+        Identify the data source so histories from equivalent clients can be shared.
+        """
+        return (self.demo_mode, self.base_url, self.api_key if not self.demo_mode else None)
+    
     def get_historical_data(self, symbol: str, timeframe: str = "M1", 
                           days_back: int = 90) -> pd.DataFrame:
         """
@@ -113,10 +150,15 @@ class cTraderDataClient:
         num_bars = days_back * 24 * 60
         
         # Use same timestamps for all symbols but different price seeds
-        # This ensures all symbols have the same time index for correlation analysis
+        # This ensures all symbols have the same time index for correlation analysis.
+        # The grid is anchored to a process-wide end time so histories generated
+        # by different clients (and shared via UniverseStore) stay aligned.
+        if cTraderDataClient._mock_end_time is None:
+            cTraderDataClient._mock_end_time = pd.Timestamp(datetime.now()).floor('1min')
+        
         if not hasattr(self, '_base_timestamps') or len(self._base_timestamps) != num_bars:
             self._base_timestamps = pd.date_range(
-                start=datetime.now() - timedelta(days=days_back),
+                end=cTraderDataClient._mock_end_time,
                 periods=num_bars,
                 freq='1min'
             )
@@ -230,25 +272,225 @@ class cTraderDataClient:
         return df[['timestamp', 'open', 'high', 'low', 'close', 'volume']]
 
 
+class UniverseStore:
+    """
+    Process-wide, reference-counted store of loaded price histories.
+    
+    Each (data source, symbol, timeframe) is fetched once and kept for the
+    longest period requested so far. Analyzers receive zero-copy row-slice
+    views of the stored DataFrames, so a 30-day analysis after a 90-day one
+    (or vice versa for overlapping symbols) starts without refetching.
+    
+    Fetches run outside the store lock: concurrent analyzers only wait for a
+    download of the same key, and an entry is freed when its last analyzer
+    releases it.
+    
+    Views are shared between analyzers and must be treated as read-only;
+    call .copy() before modifying them.
+    """
+    
+    _shared = None
+    _shared_lock = threading.Lock()
+    
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._entries = {}
+        self._pending = {}   # key -> (Event set when the fetch ends, days_back being fetched)
+    
+    @classmethod
+    def shared(cls) -> 'UniverseStore':
+        """
+        Return the process-wide store instance.
+        """
+        with cls._shared_lock:
+            if cls._shared is None:
+                cls._shared = cls()
+            return cls._shared
+    
+    def acquire(self, data_client: cTraderDataClient, symbol: str,
+                timeframe: str = "M1", days_back: int = 90) -> Tuple[Tuple, pd.DataFrame, bool]:
+        """
+        Get a view of the last `days_back` days of a symbol's history.
+        
+        Args:
+            data_client: Client used to fetch the history on a miss
+            symbol: Trading symbol
+            timeframe: Timeframe for data
+            days_back: Number of days of history required
+            
+        Returns:
+            Tuple of (entry key, DataFrame view, True if served from the store).
+            The caller owns one reference on the key and must release() it.
+        """
+        key = (data_client.source_key, symbol, timeframe)
+        
+        while True:
+            with self._lock:
+                entry = self._entries.get(key)
+                if entry is not None and entry['days_back'] >= days_back:
+                    entry['refs'] += 1
+                    return key, self._suffix_view(entry['data'], entry['days_back'], days_back), True
+                
+                pending = self._pending.get(key)
+                if pending is None or pending[1] < days_back:
+                    fetched = threading.Event()
+                    self._pending[key] = (fetched, days_back)
+                    break
+            # Another analyzer is downloading enough history for this key
+            pending[0].wait()
+        
+        try:
+            data = data_client.get_historical_data(symbol, timeframe=timeframe, days_back=days_back)
+        except Exception:
+            self._finish_fetch(key, fetched)
+            raise
+        
+        with self._lock:
+            # A longer history may have landed while this one downloaded
+            entry = self._entries.get(key)
+            if entry is None:
+                entry = {'data': data, 'days_back': days_back, 'refs': 0}
+                self._entries[key] = entry
+            elif entry['days_back'] < days_back:
+                entry['data'], entry['days_back'] = data, days_back
+            entry['refs'] += 1
+            view = self._suffix_view(entry['data'], entry['days_back'], days_back)
+        self._finish_fetch(key, fetched)
+        return key, view, False
+    
+    def _finish_fetch(self, key: Tuple, fetched: threading.Event):
+        with self._lock:
+            if self._pending.get(key, (None,))[0] is fetched:
+                del self._pending[key]
+        fetched.set()
+    
+    def release(self, keys: List[Tuple], evict: bool = True):
+        """
+        Drop one reference for each key.
+        
+        Args:
+            keys: Keys returned by acquire()
+            evict: Free entries whose last reference this was (False keeps
+                them for later analyses until evict_unused())
+        """
+        with self._lock:
+            for key in keys:
+                entry = self._entries.get(key)
+                if entry is not None and entry['refs'] > 0:
+                    entry['refs'] -= 1
+                    if evict and entry['refs'] == 0:
+                        del self._entries[key]
+    
+    def evict_unused(self) -> int:
+        """
+        Remove entries that no analyzer references.
+        
+        Returns:
+            Number of entries evicted
+        """
+        with self._lock:
+            unused = [key for key, entry in self._entries.items() if entry['refs'] == 0]
+            for key in unused:
+                del self._entries[key]
+            return len(unused)
+    
+    def memory_bytes(self) -> int:
+        """
+        Total memory held by the stored histories.
+        """
+        with self._lock:
+            return sum(int(entry['data'].memory_usage(deep=False).sum())
+                       for entry in self._entries.values())
+    
+    @staticmethod
+    def _suffix_view(data: pd.DataFrame, stored_days: int, days_back: int) -> pd.DataFrame:
+        """
+        Slice the trailing `days_back` days without copying the column data.
+        """
+        if days_back >= stored_days or data.empty:
+            return data
+        
+        cutoff = data['timestamp'].iloc[-1] - timedelta(days=days_back)
+        start = int(data['timestamp'].searchsorted(cutoff, side='right'))
+        return data.iloc[start:]
+
+
+# Score components available to rank_pairs, each mapped to a [0, 1] score
+# (higher = better) computed from the results DataFrame
+SCORE_COMPONENTS = {
+    'p_value': lambda df, horizon: 1 - df['p_value'],
+    'r_squared': lambda df, horizon: df['r_squared'],
+    'correlation': lambda df, horizon: abs(df['correlation']),
+    'residual_std': lambda df, horizon: 1 / (1 + df['residual_std']),
+    'half_life': lambda df, horizon: 1 / (1 + df['half_life'] / horizon),
+    'ecm_alpha': lambda df, horizon: (-df['ecm_alpha']).clip(0, 1),
+    'hurst': lambda df, horizon: (1 - 2 * df['hurst']).clip(0, 1),
+    'variance_ratio': lambda df, horizon: (1 - df['variance_ratio']).clip(0, 1),
+    # Requires backtest_pairs(); PnL in spread standard deviations squashed to 0-1
+    'backtest': lambda df, horizon: (df['bt_pnl_sigma'] / (1 + df['bt_pnl_sigma'].abs())).clip(0, 1)
+        if 'bt_pnl_sigma' in df else pd.Series(0.0, index=df.index),
+}
+
+# Parameters of the per-pair Engle-Granger test; part of every result cache key
+EG_CACHE_PARAMS = {
+    'test': 'engle-granger',
+    'trend': 'c',
+    'autolag': 'aic',
+    'hedge': 'ols',
+}
+
+DEFAULT_SCORE_WEIGHTS = {
+    'p_value': 0.4,
+    'r_squared': 0.3,
+    'correlation': 0.2,
+    'residual_std': 0.1,
+}
+
+
 class StatisticalArbitrageAnalyzer:
     """
     Main class for identifying cointegrated and correlated trading pairs.
     """
     
-    def __init__(self, symbols: List[str], data_client: cTraderDataClient):
+    def __init__(self, symbols: List[str], data_client: cTraderDataClient,
+                 share_data: bool = True, result_cache: Optional[PairResultCache] = None):
         """
         Initialize the analyzer.
         
         Args:
             symbols: List of trading symbols to analyze
             data_client: cTrader data client instance
+            share_data: If True, histories come from the process-wide
+                UniverseStore and are shared with other analyzers
+            result_cache: Optional disk cache of per-pair Engle-Granger results
         """
         self.symbols = symbols
         self.data_client = data_client
+        self.result_cache = result_cache
+        self.universe_store = UniverseStore.shared() if share_data else None
+        self._store_keys = []
+        if self.universe_store is not None:
+            weakref.finalize(self, self.universe_store.release, self._store_keys)
         self.price_data = {}
         self.correlation_matrix = None
+        self.correlation_pairs = None
+        self.correlation_graph = None
         self.cointegration_results = []
+        self.multi_frequency_results = []
+        self.triangle_results = pd.DataFrame()
+        self.currency_strengths = pd.DataFrame()
+        self.currency_pair_results = []
+        self.allocation = pd.DataFrame()
+        self.var_engine = None
+        self.regime_filter = None
+        self.structural_breaks = pd.DataFrame()
+        # Ranked pairs for concurrent readers (dashboards, live engine)
+        self.results = ResultsPublisher()
+        # Best-so-far pairs (by p-value) of a running scan, and its progress
+        self.scan_best = ResultsPublisher()
+        self.scan_progress = {}
     
+    @MEMORY.tracked()
     def get_data(self, days_back: int = 90) -> Dict[str, pd.DataFrame]:
         """
         Fetch historical data for all symbols.
@@ -261,11 +503,27 @@ class StatisticalArbitrageAnalyzer:
         """
         print("📊 Fetching historical data...")
         
+        # Previous references are released after the new ones are taken, so
+        # histories this call reuses are not evicted in between
+        previous_keys = list(self._store_keys)
+        self._store_keys.clear()
+        self.price_data = {}
+        
         for symbol in self.symbols:
             print(f"  ↳ Downloading {symbol}...")
             try:
-                df = self.data_client.get_historical_data(symbol, days_back=days_back)
+                if self.universe_store is not None:
+                    key, df, hit = self.universe_store.acquire(self.data_client, symbol, days_back=days_back)
+                    self._store_keys.append(key)
+                else:
+                    df, hit = self.data_client.get_historical_data(symbol, days_back=days_back), False
+                
                 self.price_data[symbol] = df
+                
+                if hit:
+                    print(f"    ♻️  {len(df)} bars reused from shared store")
+                    continue
+                
                 print(f"    ✅ {len(df)} bars retrieved")
                 
                 # Small delay to avoid rate limiting
@@ -275,15 +533,85 @@ class StatisticalArbitrageAnalyzer:
                 print(f"    ❌ Error fetching {symbol}: {e}")
                 continue
         
+        if previous_keys:
+            self.universe_store.release(previous_keys)
+        
         print(f"✅ Data collection completed for {len(self.price_data)} symbols\\n")
         return self.price_data
     
-    def compute_correlation_matrix(self) -> pd.DataFrame:
+    def release_data(self):
+        """
+        Drop this analyzer's references to shared histories; histories no
+        other analyzer holds are freed. Also runs when the analyzer is
+        garbage-collected.
+        """
+        if self.universe_store is not None and self._store_keys:
+            self.universe_store.release(self._store_keys)
+            self._store_keys.clear()
+        self.price_data = {}
+    
+    def _aligned_close_frame(self) -> pd.DataFrame:
+        """
+        Align all close series on their common timestamps.
+        
+        Returns:
+            DataFrame (timestamps x symbols); empty if fewer than two symbols overlap
+        """
+        price_series = {}
+        for symbol, df in self.price_data.items():
+            if df is None or df.empty:
+                print(f"    ⚠️  Skipping {symbol} - no data available")
+                continue
+            try:
+                price_series[symbol] = df.set_index('timestamp')['close']
+            except Exception as e:
+                print(f"    ⚠️  Error processing {symbol}: {e}")
+                continue
+        
+        if len(price_series) < 2:
+            print(f"    ❌ Not enough symbols with valid data ({len(price_series)} available)")
+            return pd.DataFrame()
+        
+        combined_df = pd.DataFrame(price_series).dropna()
+        if combined_df.empty:
+            print(f"    ❌ No overlapping data after alignment")
+        return combined_df
+    
+    def save_columnar_store(self, path: str) -> int:
+        """
+        Write the aligned close matrix as a columnar store for scan_cli.py.
+        
+        Args:
+            path: Store directory
+            
+        Returns:
+            Number of symbols written
+        """
+        combined_df = self._aligned_close_frame()
+        if combined_df.empty:
+            return 0
+        
+        write_store(path, combined_df.index.values, combined_df.values, list(combined_df.columns))
+        print(f"💾 Columnar store with {combined_df.shape[1]} symbols x {len(combined_df)} bars saved to {path}")
+        return combined_df.shape[1]
+    
+    @MEMORY.tracked()
+    def compute_correlation_matrix(self, dense: bool = True,
+                                   graph_threshold: Optional[float] = None) -> pd.DataFrame:
         """
         Compute correlation matrix for all symbol pairs.
         
+        The correlations are computed tile by tile into a packed PairMatrix
+        (self.correlation_pairs). The dense DataFrame is only expanded from it
+        when `dense` is True; pass False for large universes.
+        
+        Args:
+            dense: Also build the N x N DataFrame in self.correlation_matrix
+            graph_threshold: If set, also emit the sparse graph of pairs with
+                |correlation| >= threshold into self.correlation_graph
+        
         Returns:
-            Correlation matrix as DataFrame
+            Correlation matrix as DataFrame (empty when dense is False)
         """
         print("📈 Computing correlation matrix...")
         
@@ -321,113 +649,215 @@ class StatisticalArbitrageAnalyzer:
             self.correlation_matrix = pd.DataFrame()
             return self.correlation_matrix
         
-        # Compute correlation matrix
-        self.correlation_matrix = combined_df.corr()
+        # Compute correlation matrix into packed upper-triangular storage
+        self.correlation_pairs, graph = scan_correlations(
+            combined_df.values, list(combined_df.columns), graph_threshold=graph_threshold
+        )
+        if graph is not None:
+            self.correlation_graph = graph
+        self.correlation_matrix = self.correlation_pairs.to_dataframe() if dense else pd.DataFrame()
         
-        print(f"✅ Correlation matrix computed for {len(self.correlation_matrix)} symbols\\n")
+        print(f"✅ Correlation matrix computed for {self.correlation_pairs.n} symbols "
+              f"({self.correlation_pairs.nbytes / 1e6:.2f} MB packed)\\n")
         return self.correlation_matrix
     
-    def test_cointegration(self, significance_level: float = 0.05) -> List[Dict]:
+    def find_basket_candidates(self, correlation_threshold: float = 0.7,
+                               min_size: int = 3) -> List[Dict]:
+        """
+        Find groups of mutually correlated symbols for basket cointegration.
+        
+        Streams correlation tiles straight into a sparse graph of pairs with
+        |correlation| >= threshold (no dense or packed matrix is kept), then
+        enumerates its connected components and maximal cliques.
+        
+        Args:
+            correlation_threshold: Edge threshold (ANALYSIS_CONFIG['correlation_threshold'])
+            min_size: Minimum number of symbols in a candidate basket
+            
+        Returns:
+            List of dictionaries with 'kind' ('component' or 'clique'),
+            'symbols', 'size' and 'mean_abs_correlation'
+        """
+        print(f"🕸️  Building correlation graph (|ρ| >= {correlation_threshold})...")
+        
+        combined_df = self._aligned_close_frame()
+        if combined_df.empty:
+            return []
+        
+        _, graph = scan_correlations(combined_df.values, list(combined_df.columns),
+                                     keep_matrix=False, graph_threshold=correlation_threshold)
+        self.correlation_graph = graph
+        
+        candidates = []
+        for kind, groups in (('component', graph.components(min_size=min_size)),
+                             ('clique', graph.maximal_cliques(min_size=min_size))):
+            for members in groups:
+                candidates.append({
+                    'kind': kind,
+                    'symbols': graph.names(members),
+                    'size': len(members),
+                    'mean_abs_correlation': graph.mean_abs_correlation(members)
+                })
+        
+        components = sum(1 for c in candidates if c['kind'] == 'component')
+        print(f"✅ {graph.num_edges} edges, {components} components and "
+              f"{len(candidates) - components} cliques with >= {min_size} symbols\\n")
+        return candidates
+    
+    @MEMORY.tracked()
+    def test_cointegration(self, significance_level: float = 0.05, max_lag: int = 10,
+                           robust_method: str = 'huber', priority: str = 'correlation',
+                           deadline: Optional[float] = None, top_k: int = 10,
+                           candidate_pairs: Optional[List[Tuple[str, str]]] = None) -> List[Dict]:
         """
         Test all symbol pairs for cointegration using Engle-Granger test.
         
+        Pairs are tested in descending order of a cheap prior so strong
+        candidates are found first. While the scan runs, the best `top_k`
+        pairs so far are published to self.scan_best and progress to
+        self.scan_progress. With a deadline the scan stops cleanly, keeps
+        what it has, and bounds the cointegrated pairs it may have skipped.
+        
         Args:
             significance_level: P-value threshold for statistical significance
+            max_lag: Largest lag (in bars) searched for lead-lag relationships
+            robust_method: M-estimator for the robust hedge ratio ('huber' or 'tukey')
+            priority: Pair order: 'correlation', 'distance', 'previous' (last
+                ranking first) or 'none' (combinations order)
+            deadline: Wall-clock budget in seconds for the pair tests (None = all pairs)
+            top_k: Size of the best-so-far table
+            candidate_pairs: Restrict testing to these (symbol1, symbol2) pairs,
+                e.g. from screen_currency_factors(); None tests all pairs
             
         Returns:
             List of dictionaries containing cointegration test results
         """
         print("🔬 Testing cointegration for all pairs...")
         
-        # Align all price series
-        price_series = {}
-        for symbol, df in self.price_data.items():
-            if df is None or df.empty:
-                print(f"    ⚠️  Skipping {symbol} - no data available")
-                continue
-            try:
-                price_series[symbol] = df.set_index('timestamp')['close']
-            except Exception as e:
-                print(f"    ⚠️  Error processing {symbol}: {e}")
-                continue
-        
-        if len(price_series) < 2:
-            print(f"    ❌ Not enough symbols with valid data ({len(price_series)} available)")
-            return []
-        
-        combined_df = pd.DataFrame(price_series).dropna()
+        with MEMORY.stage('align'):
+            combined_df = self._aligned_close_frame()
         
         if combined_df.empty:
-            print(f"    ❌ No overlapping data after alignment")
             return []
         
         print(f"    📊 Data aligned: {len(combined_df)} observations for {len(combined_df.columns)} symbols")
         
-        results = []
-        available_symbols = list(combined_df.columns)
-        total_pairs = len(list(combinations(available_symbols, 2)))
-        current_pair = 0
-        
-        for symbol1, symbol2 in combinations(available_symbols, 2):
-            current_pair += 1
-            print(f"  ↳ Testing {symbol1}/{symbol2} ({current_pair}/{total_pairs})")
+        with MEMORY.stage('pair_tests'):
+            results = []
+            available_symbols = list(combined_df.columns)
+            priors = pair_priors(combined_df.values, priority,
+                                 self._previous_rank(available_symbols))
+            pair_order = priority_order(priors)
+            if candidate_pairs is not None:
+                allowed = {frozenset(pair) for pair in candidate_pairs}
+                pair_order = [(i, j) for i, j in pair_order
+                              if frozenset((available_symbols[i], available_symbols[j])) in allowed]
+                print(f"    🎯 Restricted to {len(pair_order)} candidate pairs")
+            total_pairs = len(pair_order)
+            current_pair = 0
+            best = AnytimeTopK(top_k)
+            started = time.perf_counter()
             
-            y = combined_df[symbol1].values
-            x = combined_df[symbol2].values
+            # One content fingerprint per symbol window; pair keys combine two
+            fingerprints = {}
+            if self.result_cache is not None:
+                timestamps = combined_df.index.values
+                fingerprints = {symbol: fingerprint(combined_df[symbol].values, timestamps)
+                                for symbol in available_symbols}
+        
+            for i, j in pair_order:
+                if deadline is not None and time.perf_counter() - started >= deadline:
+                    print(f"    ⏰ Deadline of {deadline:.1f}s reached after {current_pair}/{total_pairs} pairs")
+                    break
+                
+                symbol1, symbol2 = available_symbols[i], available_symbols[j]
+                current_pair += 1
+                self.scan_progress = {
+                    'tested': current_pair - 1,
+                    'total': total_pairs,
+                    'elapsed': time.perf_counter() - started,
+                }
+                print(f"  ↳ Testing {symbol1}/{symbol2} ({current_pair}/{total_pairs})")
             
-            # Validate data quality
-            if len(y) < 50 or len(x) < 50:
-                print(f"    ⚠️  Insufficient data points ({len(y)} observations)")
-                continue
+                y = combined_df[symbol1].values
+                x = combined_df[symbol2].values
             
-            if np.all(y == y[0]) or np.all(x == x[0]):
-                print(f"    ⚠️  Constant price series detected")
-                continue
+                # Validate data quality
+                if len(y) < 50 or len(x) < 50:
+                    print(f"    ⚠️  Insufficient data points ({len(y)} observations)")
+                    continue
             
-            # Perform Engle-Granger cointegration test
-            try:
-                coint_stat, p_value, critical_values = coint(y, x)
-                
-                # Calculate hedge ratio using OLS regression
-                reg = LinearRegression()
-                reg.fit(x.reshape(-1, 1), y)
-                hedge_ratio = reg.coef_[0]
-                intercept = reg.intercept_
-                
-                # Calculate R-squared
-                r_squared = reg.score(x.reshape(-1, 1), y)
-                
-                # Calculate residuals for additional statistics
-                residuals = y - (hedge_ratio * x + intercept)
-                residual_std = np.std(residuals)
-                
-                result = {
-                    'symbol1': symbol1,
-                    'symbol2': symbol2,
-                    'pair': f"{symbol1}/{symbol2}",
-                    'cointegration_stat': coint_stat,
-                    'p_value': p_value,
-                    'critical_value_1%': critical_values[0],
-                    'critical_value_5%': critical_values[1],
-                    'critical_value_10%': critical_values[2],
-                    'hedge_ratio': hedge_ratio,
-                    'intercept': intercept,
-                    'r_squared': r_squared,
-                    'residual_std': residual_std,
-                    'is_cointegrated': p_value < significance_level,
-                    'correlation': combined_df[symbol1].corr(combined_df[symbol2])
-                }
+                if np.all(y == y[0]) or np.all(x == x[0]):
+                    print(f"    ⚠️  Constant price series detected")
+                    continue
+            
+                # Perform Engle-Granger cointegration test (or reuse a cached one)
+                try:
+                    pair_stats, cached = None, False
+                    if self.result_cache is not None:
+                        cache_key = self.result_cache.pair_key(
+                            fingerprints[symbol1], fingerprints[symbol2], EG_CACHE_PARAMS
+                        )
+                        pair_stats = self.result_cache.get(cache_key)
+                        cached = pair_stats is not None
+                    
+                    if pair_stats is None:
+                        pair_stats = self._engle_granger_pair(y, x)
+                        if self.result_cache is not None:
+                            self.result_cache.put(cache_key, pair_stats)
+                    
+                    p_value = pair_stats['p_value']
+                    result = {
+                        'symbol1': symbol1,
+                        'symbol2': symbol2,
+                        'pair': f"{symbol1}/{symbol2}",
+                        'cointegration_stat': pair_stats['cointegration_stat'],
+                        'p_value': p_value,
+                        'critical_value_1%': pair_stats['critical_value_1%'],
+                        'critical_value_5%': pair_stats['critical_value_5%'],
+                        'critical_value_10%': pair_stats['critical_value_10%'],
+                        'hedge_ratio': pair_stats['hedge_ratio'],
+                        'intercept': pair_stats['intercept'],
+                        'r_squared': pair_stats['r_squared'],
+                        'residual_std': pair_stats['residual_std'],
+                        'is_cointegrated': p_value < significance_level,
+                        'correlation': pair_stats['correlation']
+                    }
                 
-                results.append(result)
+                    results.append(result)
+                    if best.push(result):
+                        self.scan_best.publish(best.items())
                 
-                if result['is_cointegrated']:
-                    print(f"    ✅ Cointegrated (p={p_value:.4f})")
-                else:
-                    print(f"    ❌ Not cointegrated (p={p_value:.4f})")
+                    source = " ♻️  cached" if cached else ""
+                    if result['is_cointegrated']:
+                        print(f"    ✅ Cointegrated (p={p_value:.4f}){source}")
+                    else:
+                        print(f"    ❌ Not cointegrated (p={p_value:.4f}){source}")
                     
-            except Exception as e:
-                print(f"    ⚠️  Error testing {symbol1}/{symbol2}: {e}")
-                continue
+                except Exception as e:
+                    print(f"    ⚠️  Error testing {symbol1}/{symbol2}: {e}")
+                    continue
+        
+            bounds = skipped_pair_bounds([r['is_cointegrated'] for r in results],
+                                         total_pairs - current_pair)
+            self.scan_progress = {
+                'tested': current_pair,
+                'total': total_pairs,
+                'elapsed': time.perf_counter() - started,
+                **bounds,
+            }
+            if bounds['skipped']:
+                print(f"    📉 {bounds['skipped']} pairs skipped; expected cointegrated among them: "
+                      f"{bounds['expected_missed']:.1f} (95% upper bound {bounds['missed_upper']:.1f})")
+        
+        # Mean-reversion diagnostics for all tested pairs in one batched pass
+        self._add_spread_diagnostics(combined_df, results)
+        
+        # Lead-lag structure of returns, sharing each symbol's FFT across pairs
+        self._add_lead_lag(combined_df, results, max_lag)
+        
+        # Spike-resistant hedge ratios for the cointegrated pairs
+        self._add_robust_hedge_ratios(combined_df, results, robust_method)
         
         self.cointegration_results = results
         cointegrated_count = sum(1 for r in results if r['is_cointegrated'])
@@ -435,6 +865,9 @@ class StatisticalArbitrageAnalyzer:
         print(f"\\n✅ Cointegration testing completed:")
         print(f"   📊 Total pairs tested: {len(results)}")
         print(f"   🎯 Cointegrated pairs found: {cointegrated_count}")
+        if self.result_cache is not None:
+            print(f"   ♻️  Result cache: {self.result_cache.hits} hits, {self.result_cache.misses} misses, "
+                  f"{self.result_cache.size_bytes / 1e6:.2f} MB")
         
         # Fix division by zero error
         if len(results) > 0:
@@ -445,10 +878,619 @@ class StatisticalArbitrageAnalyzer:
         
         return results
     
-    def rank_pairs(self) -> pd.DataFrame:
+    @staticmethod
+    def _engle_granger_pair(y: np.ndarray, x: np.ndarray) -> Dict[str, float]:
+        """
+        Engle-Granger test and OLS hedge statistics for one pair.
+        
+        Args:
+            y: Dependent close series (symbol1)
+            x: Independent close series (symbol2)
+            
+        Returns:
+            Dictionary of test and regression statistics (JSON-serializable floats)
+        """
+        coint_stat, p_value, critical_values = coint(y, x)
+        
+        # Calculate hedge ratio using OLS regression
+        reg = LinearRegression()
+        reg.fit(x.reshape(-1, 1), y)
+        hedge_ratio = reg.coef_[0]
+        intercept = reg.intercept_
+        
+        # Calculate R-squared
+        r_squared = reg.score(x.reshape(-1, 1), y)
+        
+        # Calculate residuals for additional statistics
+        residuals = y - (hedge_ratio * x + intercept)
+        residual_std = np.std(residuals)
+        
+        return {
+            'cointegration_stat': float(coint_stat),
+            'p_value': float(p_value),
+            'critical_value_1%': float(critical_values[0]),
+            'critical_value_5%': float(critical_values[1]),
+            'critical_value_10%': float(critical_values[2]),
+            'hedge_ratio': float(hedge_ratio),
+            'intercept': float(intercept),
+            'r_squared': float(r_squared),
+            'residual_std': float(residual_std),
+            'correlation': float(np.corrcoef(y, x)[0, 1]),
+        }
+    
+    @MEMORY.tracked()
+    def analyze_fx_triangles(self) -> pd.DataFrame:
+        """
+        Price every quoted FX cross against the synthetic built from two majors.
+        
+        Triangles such as EURUSD * USDCHF ~ EURCHF make one of their three
+        pairs redundant; the mispricing spread of the cross against its
+        synthetic is the tradable relationship.
+        
+        Returns:
+            DataFrame with one row per triangle: cross, legs, and mispricing
+            statistics in basis points ('mean_bps', 'std_bps', 'max_abs_bps',
+            'last_z'), widest first
+        """
+        print("🔺 Scanning FX triangles...")
+        
+        combined_df = self._aligned_close_frame()
+        if combined_df.empty:
+            self.triangle_results = pd.DataFrame()
+            return self.triangle_results
+        
+        triangles, _ = triangle_mispricing(combined_df.values, list(combined_df.columns))
+        if not triangles:
+            print("    ⚠️  No triangles among the symbols (needs a cross and both legs)\\n")
+            self.triangle_results = pd.DataFrame()
+            return self.triangle_results
+        
+        columns = ['cross', 'leg1', 'leg2', 'via', 'mean_bps', 'std_bps', 'max_abs_bps', 'last_z']
+        self.triangle_results = (pd.DataFrame(triangles)[columns]
+                                 .sort_values('std_bps', ascending=False)
+                                 .reset_index(drop=True))
+        
+        print(f"✅ {len(triangles)} triangles priced\\n")
+        return self.triangle_results
+    
+    @MEMORY.tracked()
+    def screen_currency_factors(self, significance_level: float = 0.05) -> List[Tuple[str, str]]:
+        """
+        Screen FX symbols through per-bar currency strengths.
+        
+        Solves log p_AB = s_A - s_B for all currencies at every bar, tests
+        the currency-strength pairs for cointegration, and maps the
+        cointegrated ones back to symbol pairs that isolate them (pass the
+        result to test_cointegration(candidate_pairs=...)).
+        
+        Args:
+            significance_level: P-value threshold for the currency-level screen
+            
+        Returns:
+            Candidate (symbol1, symbol2) pairs
+        """
+        print("💱 Decomposing FX quotes into currency strengths...")
+        
+        combined_df = self._aligned_close_frame()
+        if combined_df.empty:
+            return []
+        
+        symbols = list(combined_df.columns)
+        currencies, incidence, fx_columns = currency_incidence(symbols)
+        if len(fx_columns) < 2:
+            print("    ⚠️  Fewer than two FX symbols; nothing to decompose\\n")
+            return []
+        
+        log_prices = np.log(combined_df.values[:, fx_columns])
+        strengths, residuals = currency_strengths(log_prices, incidence)
+        self.currency_strengths = pd.DataFrame(strengths, index=combined_df.index, columns=currencies)
+        
+        rms_bps = np.sqrt((residuals ** 2).mean()) * 1e4
+        print(f"    📊 {len(fx_columns)} FX symbols -> {len(currencies)} currencies "
+              f"(quote residual RMS {rms_bps:.2f} bps)")
+        
+        self.currency_pair_results = cointegrated_currency_pairs(strengths, currencies, significance_level)
+        candidates = map_to_symbol_pairs(symbols, self.currency_pair_results)
+        
+        total = len(fx_columns) * (len(fx_columns) - 1) // 2
+        print(f"✅ {len(self.currency_pair_results)} cointegrated currency pairs -> "
+              f"{len(candidates)}/{total} candidate symbol pairs\\n")
+        return candidates
+    
+    def _previous_rank(self, symbols: List[str]) -> Dict[Tuple[int, int], int]:
+        """
+        Rank of each pair (by column positions) in the last published ranking.
+        """
+        position = {symbol: i for i, symbol in enumerate(symbols)}
+        snapshot = self.results.current()
+        if not len(snapshot):
+            return {}
+        
+        ranks = {}
+        for rank, (symbol1, symbol2) in enumerate(zip(snapshot.column('symbol1'), snapshot.column('symbol2'))):
+            if symbol1 in position and symbol2 in position:
+                ranks[(position[symbol1], position[symbol2])] = rank
+        return ranks
+    
+    @MEMORY.tracked()
+    def test_cointegration_multi_frequency(self, strides: Tuple[int, ...] = (1, 5, 15, 60),
+                                           significance_level: float = 0.05) -> List[Dict]:
+        """
+        Test all symbol pairs for cointegration at several sampling frequencies.
+        
+        The aligned close matrix is streamed once; each stride samples it
+        through a strided view and all pairs are tested from the accumulated
+        moments (zero-lag Engle-Granger), so no per-frequency DataFrames are built.
+        
+        Args:
+            strides: Sampling strides in bars (1, 5, 15, 60 = 1m/5m/15m/1h on M1 data)
+            significance_level: P-value threshold for statistical significance
+            
+        Returns:
+            List of dictionaries with per-stride columns suffixed `_s<stride>`
+        """
+        print(f"🔬 Testing cointegration at strides {', '.join(map(str, strides))}...")
+        
+        combined_df = self._aligned_close_frame()
+        if combined_df.empty:
+            return []
+        
+        usable_strides = tuple(s for s in strides if len(combined_df) // s >= 50)
+        if len(usable_strides) < len(strides):
+            print(f"    ⚠️  Skipping strides with fewer than 50 samples: "
+                  f"{sorted(set(strides) - set(usable_strides))}")
+        if not usable_strides:
+            return []
+        
+        by_stride = multi_frequency_cointegration(combined_df.values, usable_strides)
+        
+        results = []
+        symbols = list(combined_df.columns)
+        for i, j in combinations(range(len(symbols)), 2):
+            result = {
+                'symbol1': symbols[i],
+                'symbol2': symbols[j],
+                'pair': f"{symbols[i]}/{symbols[j]}",
+            }
+            for stride, stats in by_stride.items():
+                result[f'p_value_s{stride}'] = stats['p_value'][i, j]
+                result[f'df_stat_s{stride}'] = stats['df_stat'][i, j]
+                result[f'hedge_ratio_s{stride}'] = stats['hedge_ratio'][i, j]
+                result[f'is_cointegrated_s{stride}'] = stats['p_value'][i, j] < significance_level
+            result['strides_cointegrated'] = sum(
+                result[f'is_cointegrated_s{stride}'] for stride in by_stride
+            )
+            results.append(result)
+        
+        self.multi_frequency_results = results
+        
+        for stride in usable_strides:
+            count = sum(1 for r in results if r[f'is_cointegrated_s{stride}'])
+            print(f"   📊 Stride {stride}: {count}/{len(results)} pairs cointegrated "
+                  f"({by_stride[stride]['n_obs']} samples)")
+        print()
+        
+        return results
+    
+    @MEMORY.tracked()
+    def backtest_pairs(self, window: int = 50, entry_z: float = 2.0, exit_z: float = 0.5,
+                       stop_z: float = np.inf, max_hold: int = 30,
+                       use_robust_hedge: bool = True) -> pd.DataFrame:
+        """
+        Simulate the bot's z-score rules on every cointegrated pair at once.
+        
+        Spreads are built from the aligned closes with the robust hedge ratio
+        when available (OLS otherwise). Results gain 'bt_pnl', 'bt_pnl_sigma',
+        'bt_trades', 'bt_win_rate' and 'bt_time_in_market'.
+        
+        Args:
+            window: Rolling z-score window in bars (bot WindowSize)
+            entry_z: Entry threshold (bot EntryThreshold)
+            exit_z: Exit threshold (bot ExitThreshold)
+            stop_z: Adverse z-score stop, e.g. STRATEGY_CONFIG stop_loss_zscore
+                (not a cBot rule; inf = off, like the bot)
+            max_hold: Bars before the time-based exit (the bot's
+                MaxTradeDurationMinutes counts minutes; equal on gap-free M1)
+            use_robust_hedge: Prefer robust_hedge_ratio over the OLS hedge_ratio
+            
+        Returns:
+            DataFrame of backtest statistics per pair, best pnl_sigma first
+        """
+        cointegrated = [r for r in self.cointegration_results if r['is_cointegrated']]
+        if not cointegrated:
+            print("❌ No cointegrated pairs to backtest. Run cointegration test first.")
+            return pd.DataFrame()
+        
+        print(f"⏱️  Backtesting {len(cointegrated)} pairs (window={window}, entry={entry_z}, exit={exit_z})...")
+        
+        combined_df = self._aligned_close_frame()
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = np.array([column_index[r['symbol1']] for r in cointegrated])
+        idx2 = np.array([column_index[r['symbol2']] for r in cointegrated])
+        
+        hedge_ratios = np.array([
+            r['robust_hedge_ratio'] if use_robust_hedge and np.isfinite(r.get('robust_hedge_ratio', np.nan))
+            else r['hedge_ratio']
+            for r in cointegrated
+        ])
+        
+        prices = combined_df.values
+        spreads = prices[:, idx1] - prices[:, idx2] * hedge_ratios
+        stats = backtest_spreads(spreads, window=window, entry_z=entry_z, exit_z=exit_z,
+                                 stop_z=stop_z, max_hold=max_hold)
+        
+        for i, result in enumerate(cointegrated):
+            result['bt_pnl'] = stats['pnl'][i]
+            result['bt_pnl_sigma'] = stats['pnl_sigma'][i]
+            result['bt_trades'] = int(stats['trades'][i])
+            result['bt_win_rate'] = stats['win_rate'][i]
+            result['bt_time_in_market'] = stats['time_in_market'][i]
+        
+        summary = pd.DataFrame({
+            'pair': [r['pair'] for r in cointegrated],
+            **stats,
+        }).sort_values('pnl_sigma', ascending=False)
+        
+        print(f"✅ Backtest completed: {int(stats['trades'].sum())} trades, "
+              f"{(stats['pnl'] > 0).sum()}/{len(cointegrated)} pairs profitable\\n")
+        return summary
+    
+    @MEMORY.tracked()
+    def detect_regimes(self, n_states: int = 2, max_bars: Optional[int] = 20000,
+                       max_iter: int = 50) -> pd.DataFrame:
+        """
+        Fit a Gaussian HMM to every cointegrated pair's residual series.
+        
+        Residuals y - (hedge_ratio * x + intercept) from the Engle-Granger fit
+        are standardized and all pairs are fitted in one batch. Results gain
+        'regime_state' (most likely state at the last bar, 0 = calmest),
+        'regime_volatile_prob' (filtered probability of the most volatile
+        state), 'regime_vol_ratio' (volatile / calm state std) and
+        'regime_calm_persistence' (calm state's stay probability). A
+        RegimeFilter seeded at the last bar is kept in self.regime_filter;
+        its update() takes raw residuals y - (hedge_ratio * x + intercept)
+        and applies the standardization itself.
+        
+        Args:
+            n_states: Hidden states per pair (2 or 3)
+            max_bars: Fit on the most recent bars only (all if None)
+            max_iter: Baum-Welch iteration limit
+            
+        Returns:
+            DataFrame of regime statistics per pair
+        """
+        cointegrated = [r for r in self.cointegration_results if r['is_cointegrated']]
+        if not cointegrated:
+            print("❌ No cointegrated pairs for regime detection. Run cointegration test first.")
+            return pd.DataFrame()
+        
+        combined_df = self._aligned_close_frame()
+        if max_bars is not None:
+            combined_df = combined_df.iloc[-max_bars:]
+        print(f"🌦️  Fitting {n_states}-state HMMs to {len(cointegrated)} spreads ({len(combined_df)} bars)...")
+        
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = np.array([column_index[r['symbol1']] for r in cointegrated])
+        idx2 = np.array([column_index[r['symbol2']] for r in cointegrated])
+        hedge_ratios = np.array([r['hedge_ratio'] for r in cointegrated])
+        intercepts = np.array([r['intercept'] for r in cointegrated])
+        
+        prices = combined_df.values
+        residuals = prices[:, idx1] - (prices[:, idx2] * hedge_ratios + intercepts)
+        scale = residuals.std(axis=0)
+        model = fit_hmm(residuals / scale, n_states=n_states, max_iter=max_iter)
+        # The filter keeps the scale, so the live engine feeds it raw residuals
+        self.regime_filter = RegimeFilter(model, scale=scale)
+        
+        std = np.sqrt(model['var'])
+        for i, result in enumerate(cointegrated):
+            result['regime_state'] = int(model['state_prob'][i].argmax())
+            result['regime_volatile_prob'] = model['state_prob'][i, -1]
+            result['regime_vol_ratio'] = std[i, -1] / std[i, 0]
+            result['regime_calm_persistence'] = model['transition'][i, 0, 0]
+        
+        summary = pd.DataFrame({
+            'pair': [r['pair'] for r in cointegrated],
+            'regime_state': [r['regime_state'] for r in cointegrated],
+            'regime_volatile_prob': model['state_prob'][:, -1],
+            'regime_vol_ratio': std[:, -1] / std[:, 0],
+            'regime_calm_persistence': model['transition'][:, 0, 0],
+            'loglik': model['loglik'],
+        })
+        
+        volatile = int((summary['regime_state'] == n_states - 1).sum())
+        print(f"✅ Regimes fitted: {volatile}/{len(cointegrated)} pairs currently in the volatile state\\n")
+        return summary
+
+    @MEMORY.tracked()
+    def test_structural_breaks(self, significance_level: float = 0.05,
+                               trim: float = DEFAULT_TRIM) -> pd.DataFrame:
+        """
+        Gregory-Hansen test for cointegration with one level shift on every tested pair.
+
+        All candidate break dates of all pairs are scanned in one batch
+        (see structural_breaks). Results gain 'gh_stat' (ADF*), 'gh_p_value',
+        'gh_break_date', 'gh_level_shift', the post-break fit
+        ('gh_hedge_ratio', 'gh_intercept', 'gh_residual_std') and
+        'gh_cointegrated'. Engle-Granger fields and 'is_cointegrated' are
+        left unchanged, so ranking still describes the full-sample spread.
+
+        ADF* is a minimum over break dates and is taken over every tested
+        pair, so 'gh_cointegrated' uses a Bonferroni-corrected level
+        (significance_level / number of pairs).
+
+        Args:
+            significance_level: Family-wise error rate across the tested pairs
+            trim: Fraction of the sample excluded from each end of the break search
+
+        Returns:
+            DataFrame of break statistics per pair, strongest first
+        """
+        if not self.cointegration_results:
+            print("❌ No tested pairs for the break test. Run cointegration test first.")
+            return pd.DataFrame()
+
+        combined_df = self._aligned_close_frame()
+        tested = self.cointegration_results
+        print(f"🪓 Gregory-Hansen break search on {len(tested)} pairs ({len(combined_df)} bars)...")
+
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = np.array([column_index[r['symbol1']] for r in tested])
+        idx2 = np.array([column_index[r['symbol2']] for r in tested])
+        stats = gregory_hansen(combined_df.values, idx1, idx2, trim=trim)
+        break_dates = combined_df.index[stats['break_index']]
+        corrected_level = significance_level / len(tested)
+        significant = stats['p_value'] < corrected_level
+        post_break_intercept = stats['intercept'] + stats['level_shift']
+
+        for i, result in enumerate(tested):
+            result['gh_stat'] = stats['adf_stat'][i]
+            result['gh_p_value'] = stats['p_value'][i]
+            result['gh_break_date'] = break_dates[i]
+            result['gh_level_shift'] = stats['level_shift'][i]
+            result['gh_hedge_ratio'] = stats['hedge_ratio'][i]
+            result['gh_intercept'] = post_break_intercept[i]
+            result['gh_residual_std'] = stats['residual_std'][i]
+            result['gh_cointegrated'] = bool(significant[i])
+
+        summary = pd.DataFrame({
+            'pair': [r['pair'] for r in tested],
+            'gh_stat': stats['adf_stat'],
+            'gh_p_value': stats['p_value'],
+            'gh_break_date': break_dates,
+            'gh_level_shift': stats['level_shift'],
+            'gh_hedge_ratio': stats['hedge_ratio'],
+            'gh_intercept': post_break_intercept,
+            'gh_cointegrated': significant,
+            'is_cointegrated': [r['is_cointegrated'] for r in tested],
+        }).sort_values('gh_stat')
+        self.structural_breaks = summary
+
+        break_only = int((summary['gh_cointegrated'] & ~summary['is_cointegrated']).sum())
+        print(f"✅ {int(significant.sum())}/{len(tested)} pairs cointegrated with a level shift "
+              f"(p < {corrected_level:.2g} after Bonferroni); {break_only} rejected by Engle-Granger\\n")
+        return summary
+
+    @MEMORY.tracked()
+    def allocate_portfolio(self, method: str = 'mean_variance', lookback_bars: Optional[int] = None,
+                           allocator: Optional[PortfolioAllocator] = None) -> pd.DataFrame:
+        """
+        Split capital across the ranked pairs within the configured limits.
+        
+        Pair returns on gross capital come from the aligned closes and each
+        pair's (robust, when available) hedge ratio; the composite score is
+        the expected edge. Limits default to RISK_CONFIG max_total_exposure
+        and STRATEGY_CONFIG position_size_pct / max_positions.
+        
+        Args:
+            method: 'mean_variance' or 'risk_parity'
+            lookback_bars: Trailing bars for the spread covariance (all if None)
+            allocator: Allocator to reuse across calls (keeps its warm start)
+            
+        Returns:
+            DataFrame with 'pair', 'weight' and 'risk_share' per allocated pair
+        """
+        snapshot = self.results.current()
+        ranked = snapshot.to_dataframe() if len(snapshot) else self.rank_pairs()
+        if ranked.empty:
+            print("❌ No ranked pairs to allocate. Run cointegration test first.")
+            return pd.DataFrame()
+        
+        if allocator is None:
+            allocator = PortfolioAllocator.from_config(method=method)
+        print(f"💼 Allocating across {len(ranked)} pairs ({allocator.method}, "
+              f"max {allocator.max_positions} positions, {allocator.max_total_exposure:.0%} exposure)...")
+        
+        combined_df = self._aligned_close_frame()
+        if lookback_bars is not None:
+            combined_df = combined_df.iloc[-(lookback_bars + 1):]
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = ranked['symbol1'].map(column_index).values.astype(int)
+        idx2 = ranked['symbol2'].map(column_index).values.astype(int)
+        hedge_ratios = ranked['hedge_ratio'].values.astype(float)
+        if 'robust_hedge_ratio' in ranked:
+            robust = ranked['robust_hedge_ratio'].values.astype(float)
+            hedge_ratios = np.where(np.isfinite(robust), robust, hedge_ratios)
+        
+        cov = shrunk_covariance(pair_returns(combined_df.values, idx1, idx2, hedge_ratios))
+        weights = allocator.allocate(ranked['composite_score'].values, cov)
+        risk = risk_contributions(weights, cov)
+        
+        held = weights > 0
+        self.allocation = pd.DataFrame({
+            'pair': ranked['pair'].values[held],
+            'weight': weights[held],
+            'risk_share': risk['contribution'][held],
+        }).sort_values('weight', ascending=False)
+        
+        print(f"✅ {held.sum()} pairs allocated, total exposure {weights.sum():.1%}\\n")
+        return self.allocation
+    
+    @MEMORY.tracked()
+    def portfolio_var(self) -> Dict[str, float]:
+        """
+        Historical and parametric VaR/CVaR of the allocated portfolio.
+        
+        Replays each allocated pair's per-bar return on gross capital through
+        an IncrementalVaR engine configured from RISK_CONFIG (var_confidence,
+        lookback_var_days). The engine is kept in self.var_engine so a live
+        loop can continue with on_bar() and set_weights().
+        
+        Returns:
+            Dictionary with 'hist_var', 'hist_cvar', 'param_var', 'param_cvar'
+            as fractions of capital, plus 'confidence' and 'observations'
+        """
+        if self.allocation.empty:
+            print("❌ No allocation. Run allocate_portfolio() first.")
+            return {}
+        
+        ranked = self.results.current().to_dataframe().set_index('pair').loc[self.allocation['pair']]
+        combined_df = self._aligned_close_frame()
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = ranked['symbol1'].map(column_index).values.astype(int)
+        idx2 = ranked['symbol2'].map(column_index).values.astype(int)
+        hedge_ratios = ranked['hedge_ratio'].values.astype(float)
+        if 'robust_hedge_ratio' in ranked:
+            robust = ranked['robust_hedge_ratio'].values.astype(float)
+            hedge_ratios = np.where(np.isfinite(robust), robust, hedge_ratios)
+        
+        returns = pair_returns(combined_df.values, idx1, idx2, hedge_ratios)
+        self.var_engine = IncrementalVaR.from_config(len(idx1), weights=self.allocation['weight'].values)
+        for bar in returns[-self.var_engine.lookback_bars:]:
+            self.var_engine.on_bar(bar)
+        
+        report = self.var_engine.report()
+        print(f"📉 {report['confidence']:.0%} VaR over {report['observations']} bars: "
+              f"historical {report['hist_var']:.4%} (CVaR {report['hist_cvar']:.4%}), "
+              f"parametric {report['param_var']:.4%} (CVaR {report['param_cvar']:.4%})\\n")
+        return report
+    
+    @MEMORY.tracked('spread_diagnostics')
+    def _add_spread_diagnostics(self, combined_df: pd.DataFrame, results: List[Dict]):
+        """
+        Attach mean-reversion diagnostics to the cointegration results.
+        
+        Reuses the hedge ratios and intercepts from the Engle-Granger step so
+        the residuals are rebuilt once per pair instead of refitting. Adds
+        OU half-life, ECM adjustment speed, DFA Hurst exponent and
+        Lo-MacKinlay variance ratios.
+        
+        Args:
+            combined_df: Aligned close prices used for the cointegration test
+            results: Cointegration results, updated in place
+        """
+        if not results:
+            return
+        
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = np.array([column_index[r['symbol1']] for r in results])
+        idx2 = np.array([column_index[r['symbol2']] for r in results])
+        hedge_ratios = np.array([r['hedge_ratio'] for r in results])
+        intercepts = np.array([r['intercept'] for r in results])
+        
+        diagnostics = compute_spread_diagnostics(
+            combined_df.values, idx1, idx2, hedge_ratios, intercepts
+        )
+        
+        for i, result in enumerate(results):
+            for key, values in diagnostics.items():
+                if key != 'ar_coefficient':
+                    result[key] = values[i]
+    
+    @MEMORY.tracked('lead_lag')
+    def _add_lead_lag(self, combined_df: pd.DataFrame, results: List[Dict], max_lag: int):
+        """
+        Attach the peak cross-correlation lag of returns to each result.
+        
+        A positive `lead_lag` means symbol2 leads symbol1 by that many bars.
+        
+        Args:
+            combined_df: Aligned close prices used for the cointegration test
+            results: Cointegration results, updated in place
+            max_lag: Largest lag (in bars) to search
+        """
+        if not results or max_lag <= 0:
+            return
+        
+        returns = np.diff(np.log(combined_df.values), axis=0)
+        
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = np.array([column_index[r['symbol1']] for r in results])
+        idx2 = np.array([column_index[r['symbol2']] for r in results])
+        
+        lead_lag = lead_lag_cross_correlation(returns, idx1, idx2, max_lag)
+        
+        for i, result in enumerate(results):
+            result['lead_lag'] = int(lead_lag['lead_lag'][i])
+            result['lead_lag_corr'] = lead_lag['lead_lag_corr'][i]
+    
+    @MEMORY.tracked('robust_hedge')
+    def _add_robust_hedge_ratios(self, combined_df: pd.DataFrame, results: List[Dict],
+                                 method: str):
+        """
+        Attach IRLS robust hedge ratios to the cointegrated pairs.
+        
+        The OLS fit from the Engle-Granger step is the warm start. Pairs that
+        are not cointegrated get NaN.
+        
+        Args:
+            combined_df: Aligned close prices used for the cointegration test
+            results: Cointegration results, updated in place
+            method: 'huber' or 'tukey'
+        """
+        for result in results:
+            result['robust_hedge_ratio'] = np.nan
+            result['robust_intercept'] = np.nan
+        
+        cointegrated = [r for r in results if r['is_cointegrated']]
+        if not cointegrated:
+            return
+        
+        column_index = {symbol: i for i, symbol in enumerate(combined_df.columns)}
+        idx1 = np.array([column_index[r['symbol1']] for r in cointegrated])
+        idx2 = np.array([column_index[r['symbol2']] for r in cointegrated])
+        hedge_ratios = np.array([r['hedge_ratio'] for r in cointegrated])
+        intercepts = np.array([r['intercept'] for r in cointegrated])
+        
+        robust = robust_hedge_ratios(combined_df.values, idx1, idx2,
+                                     hedge_ratios, intercepts, method=method)
+        
+        for i, result in enumerate(cointegrated):
+            result['robust_hedge_ratio'] = robust['robust_hedge_ratio'][i]
+            result['robust_intercept'] = robust['robust_intercept'][i]
+    
+    def pair_matrix(self, field: str) -> PairMatrix:
+        """
+        Pack a per-pair cointegration statistic into a PairMatrix.
+        
+        Args:
+            field: Result key, e.g. 'p_value', 'hedge_ratio' or 'half_life'
+            
+        Returns:
+            Strict (no diagonal) PairMatrix indexed by (symbol1, symbol2)
+        """
+        symbols = []
+        for result in self.cointegration_results:
+            for symbol in (result['symbol1'], result['symbol2']):
+                if symbol not in symbols:
+                    symbols.append(symbol)
+        
+        pairs = [(r['symbol1'], r['symbol2']) for r in self.cointegration_results]
+        values = [r.get(field, np.nan) for r in self.cointegration_results]
+        return PairMatrix.from_pairs(symbols, pairs, values)
+    
+    @MEMORY.tracked()
+    def rank_pairs(self, score_weights: Optional[Dict[str, float]] = None,
+                   half_life_horizon: float = 30.0) -> pd.DataFrame:
         """
         Rank pairs by cointegration strength and other criteria.
         
+        Args:
+            score_weights: Mapping of score component to weight. Components are
+                the keys of SCORE_COMPONENTS; defaults to DEFAULT_SCORE_WEIGHTS.
+            half_life_horizon: Holding horizon in bars used to score half-life
+                (matches the bot's MaxTradeDurationMinutes on M1 data)
+        
         Returns:
             DataFrame with ranked cointegrated pairs
         """
@@ -468,39 +1510,80 @@ class StatisticalArbitrageAnalyzer:
         # Higher R-squared = better (stronger relationship)
         # Lower residual std = better (more stable relationship)
         
+        # Shorter half-life relative to the holding horizon = better
+        # More negative ECM alpha = faster error correction = better
+        # Hurst < 0.5 and variance ratio < 1 = anti-persistent spread = better
+        
+        if score_weights is None:
+            score_weights = DEFAULT_SCORE_WEIGHTS
+        
+        unknown = set(score_weights) - set(SCORE_COMPONENTS)
+        if unknown:
+            raise ValueError(f"Unknown score components: {sorted(unknown)}")
+        
         df['p_value_score'] = 1 - df['p_value']  # Invert p-value (higher = better)
-        df['composite_score'] = (
-            0.4 * df['p_value_score'] +
-            0.3 * df['r_squared'] +
-            0.2 * abs(df['correlation']) +
-            0.1 * (1 / (1 + df['residual_std']))  # Inverse of residual std
-        )
+        df['composite_score'] = 0.0
+        for component, weight in score_weights.items():
+            score = SCORE_COMPONENTS[component](df, half_life_horizon)
+            df['composite_score'] += weight * score.fillna(0)
         
         # Sort by composite score (descending)
         df_ranked = df.sort_values('composite_score', ascending=False)
         
-        print(f"✅ {len(df_ranked)} cointegrated pairs ranked\\n")
+        snapshot = self.results.publish(df_ranked)
+        
+        print(f"✅ {len(df_ranked)} cointegrated pairs ranked (results v{snapshot.version})\\n")
         return df_ranked
     
-    def plot_correlation_heatmap(self, save_path: str = "correlation_heatmap.png"):
+    def plot_correlation_heatmap(self, save_path: str = "correlation_heatmap.png",
+                                 cluster: bool = True, annotate_max: int = 30,
+                                 pyramid_dir: Optional[str] = None, show: bool = False):
         """
         Create and save correlation heatmap.
         
+        Symbols are reordered by hierarchical clustering. Up to `annotate_max`
+        symbols the labelled, annotated seaborn chart is drawn; above that the
+        matrix is rasterized straight to PNG (symbol order in a .json sidecar),
+        which handles thousands of symbols without a display.
+        
         Args:
             save_path: Path to save the heatmap image
+            cluster: Reorder symbols so correlated groups are adjacent
+            annotate_max: Largest universe drawn with labels and values
+            pyramid_dir: If set, also write a tiled zoom pyramid there
+            show: Open an interactive window (seaborn chart only)
         """
-        if self.correlation_matrix is None:
-            self.compute_correlation_matrix()
+        if self.correlation_pairs is None:
+            self.compute_correlation_matrix(dense=False)
         
-        if self.correlation_matrix is None or self.correlation_matrix.empty:
+        if self.correlation_pairs is None or self.correlation_pairs.n == 0:
             print("❌ No correlation matrix available for plotting")
             return
         
+        # Tiles are read from the packed matrix in cluster order; the dense
+        # N x N matrix is never built
+        pairs = self.correlation_pairs
+        order = cluster_order(pairs) if cluster else np.arange(pairs.n)
+        symbols = [pairs.symbols[i] for i in order]
+        
+        if pyramid_dir is not None:
+            index = render_pyramid(pairs, pyramid_dir, symbols, order=order)
+            print(f"🗺️  Heatmap pyramid ({len(index['levels'])} levels) written to {pyramid_dir}")
+        
+        if len(symbols) > annotate_max:
+            info = render_heatmap(pairs, save_path, order=order)
+            with open(save_path + '.json', 'w') as f:
+                json.dump({'symbols': symbols, **{k: v for k, v in info.items() if k != 'path'}}, f)
+            print(f"📊 Correlation heatmap ({len(symbols)} symbols, {info['pixels']}px) saved to {save_path}")
+            return
+        
+        correlation_df = pd.DataFrame(pairs.take(order, order), index=symbols, columns=symbols)
+        
         plt.figure(figsize=(10, 8))
-        mask = np.triu(np.ones_like(self.correlation_matrix, dtype=bool))
+        mask = np.triu(np.ones_like(correlation_df, dtype=bool))
         
         sns.heatmap(
-            self.correlation_matrix, 
+            correlation_df, 
             mask=mask,
             annot=True, 
             cmap='RdYlBu_r', 
@@ -513,7 +1596,9 @@ class StatisticalArbitrageAnalyzer:
         plt.title('Currency Pairs Correlation Matrix', fontsize=16, fontweight='bold')
         plt.tight_layout()
         plt.savefig(save_path, dpi=300, bbox_inches='tight')
-        plt.show()
+        if show:
+            plt.show()
+        plt.close()
         
         print(f"📊 Correlation heatmap saved to {save_path}")
     
@@ -537,12 +1622,19 @@ class StatisticalArbitrageAnalyzer:
         # Select and reorder columns for output
         output_columns = [
             'pair', 'symbol1', 'symbol2', 'composite_score',
-            'p_value', 'cointegration_stat', 'hedge_ratio', 
+            'p_value', 'cointegration_stat', 'hedge_ratio', 'robust_hedge_ratio',
             'r_squared', 'correlation', 'residual_std',
-            'critical_value_5%', 'intercept'
+            'half_life', 'ecm_alpha', 'hurst', 'variance_ratio',
+            'lead_lag', 'lead_lag_corr',
+            'bt_pnl_sigma', 'bt_trades', 'bt_win_rate',
+            'regime_state', 'regime_volatile_prob',
+            'gh_stat', 'gh_p_value', 'gh_break_date', 'gh_level_shift',
+            'critical_value_5%', 'intercept', 'robust_intercept'
         ]
         
-        df_output = df[output_columns].round(6)
+        # Backtest, regime and break columns are only present after backtest_pairs() /
+        # detect_regimes() / test_structural_breaks()
+        df_output = df[[c for c in output_columns if c in df.columns]].round(6)
         
         try:
             df_output.to_csv(filename, index=False)
@@ -570,7 +1662,8 @@ def main():
     
     print(f"🎯 Target symbols: {', '.join(SYMBOLS)}")
     print(f"📅 Analysis period: {DAYS_BACK} days")
-    print(f"📊 Significance level: {SIGNIFICANCE_LEVEL}\\n")
+    print(f"📊 Significance level: {SIGNIFICANCE_LEVEL}")
+    print(f"🧮 Kernel variant: {KERNEL_VARIANT['active']} ({KERNEL_VARIANT['source']})\\n")
     
     # Initialize data client using config
     from config import CTRADER_CONFIG
@@ -579,8 +1672,8 @@ def main():
         demo_mode=CTRADER_CONFIG.get('demo_mode', True)
     )
     
-    # Initialize analyzer
-    analyzer = StatisticalArbitrageAnalyzer(SYMBOLS, client)
+    # Initialize analyzer; unchanged pair windows are served from the result cache
+    analyzer = StatisticalArbitrageAnalyzer(SYMBOLS, client, result_cache=PairResultCache())
     
     try:
         # Step 1: Fetch historical data
@@ -592,12 +1685,25 @@ def main():
         # Step 3: Test for cointegration
         analyzer.test_cointegration(significance_level=SIGNIFICANCE_LEVEL)
         
-        # Step 4: Rank and save results
+        # Step 4: Screen cointegrated pairs with the bot's signal rules plus the config's z-stop
+        from config import STRATEGY_CONFIG
+        analyzer.backtest_pairs(
+            entry_z=STRATEGY_CONFIG['entry_zscore_threshold'],
+            exit_z=STRATEGY_CONFIG['exit_zscore_threshold'],
+            stop_z=STRATEGY_CONFIG['stop_loss_zscore'],
+        )
+        
+        # Step 5: Rank and save results
         analyzer.save_results("cointegrated_pairs.csv")
         
-        # Step 5: Create visualizations
+        # Step 6: Create visualizations
         analyzer.plot_correlation_heatmap("correlation_heatmap.png")
         
+        if MEMORY.enabled:
+            print("\\n🧠 Memory by stage:")
+            print(MEMORY.format_report())
+            MEMORY.save_report("memory_report.json")
+        
         print("\\n🎉 Analysis completed successfully!")
         print("📁 Output files:")
         print("   • cointegrated_pairs.csv - Ranked cointegrated pairs")
@@ -0,0 +1,195 @@
+"""
+Structural Breaks - Gregory-Hansen cointegration test with a level shift
+
+Engle-Granger rejects pairs whose long-run relationship shifts level once
+(a corporate event, a peg change). Gregory and Hansen (1996) test for
+cointegration against that alternative: for every candidate break date Tb
+in the trimmed middle of the sample, fit
+
+    y_t = a + mu * D_t + b * x_t + e_t,    D_t = 1 for t >= Tb
+
+and run the Dickey-Fuller regression de_t = rho * e_{t-1} on the residuals.
+The statistic ADF* is the smallest t-statistic over all break dates, and
+the minimizing Tb is the estimated break.
+
+No regression is refitted per break date. With both series centered, the
+only break-dependent inputs are suffix sums of y and x, read from one
+prefix-sum array per chunk. The level regression follows from a 2 x 2
+system (Frisch-Waugh on the dummy and x). The residual sums the
+Dickey-Fuller statistic needs are quadratic forms in full-sample and lag-1
+moments plus the residuals at the two ends of the sample. Every break of
+every pair in a chunk is then a few length-(breaks x pairs) array
+operations.
+
+Note: this is the zero-lag ADF*, as in cointegration_engine; Gregory and
+Hansen's critical values assume lags are added until the residual
+autocorrelation is gone.
+"""
+
+import os
+import numpy as np
+from concurrent.futures import ThreadPoolExecutor
+from statistics import NormalDist
+from typing import Dict, Optional
+
+# Model C (level shift), one regressor: ADF* critical values at 1%, 5%, 10%
+# (Gregory and Hansen 1996, Table 1)
+GH_CRITICAL_VALUES = {0.01: -5.13, 0.05: -4.61, 0.10: -4.34}
+
+# Only three quantiles are tabulated. They lie almost exactly on a normal
+# left tail, so p-values come from the normal fitted to them by least squares
+_levels = sorted(GH_CRITICAL_VALUES)
+_z = np.array([NormalDist().inv_cdf(level) for level in _levels])
+GH_NULL_STD, GH_NULL_MEAN = np.polyfit(_z, [GH_CRITICAL_VALUES[level] for level in _levels], 1)
+
+# Fraction of the sample excluded from each end of the break search
+DEFAULT_TRIM = 0.15
+
+# Breaks x pairs cells evaluated per chunk. A chunk peaks at about 16 live
+# working arrays of this many float64s (16 x 8 bytes x BREAK_CELLS, ~70 MB)
+BREAK_CELLS = 1 << 19
+
+# Worker threads by default; peak memory is about workers x one chunk (~280 MB)
+DEFAULT_WORKERS = 4
+
+
+def gh_pvalues(stats: np.ndarray) -> np.ndarray:
+    """
+    Approximate left-tail p-values of ADF* statistics.
+
+    Exact at the tabulated 1/5/10% levels to within about 0.1 points;
+    further out the normal tail is an extrapolation.
+    """
+    stats = np.asarray(stats, dtype=float)
+    ncdf = np.frompyfunc(NormalDist(GH_NULL_MEAN, GH_NULL_STD).cdf, 1, 1)
+    return np.where(np.isnan(stats), np.nan, ncdf(np.nan_to_num(stats)).astype(float))
+
+
+def _break_chunk(y: np.ndarray, x: np.ndarray, breaks: np.ndarray) -> Dict[str, np.ndarray]:
+    """
+    ADF* over the candidate breaks for a chunk of pairs.
+
+    Args:
+        y, x: (T, p) dependent and regressor series
+        breaks: (B,) consecutive candidate break indices, 1 <= Tb <= T - 1
+
+    Returns:
+        Dictionary of (p,) arrays at the minimizing break
+    """
+    n = len(y)
+    m = n - 1
+    y_mean, x_mean = y.mean(axis=0), x.mean(axis=0)
+    y = y - y_mean
+    x = x - x_mean
+
+    # Break-independent moments of the centered series
+    syy = np.einsum('tp,tp->p', y, y)
+    sxy = np.einsum('tp,tp->p', x, y)
+    sxx = np.einsum('tp,tp->p', x, x)
+    cyy = np.einsum('tp,tp->p', y[1:], y[:-1])                   # sum y_k y_{k-1}
+    cyx = np.einsum('tp,tp->p', y[1:], x[:-1])
+    cxy = np.einsum('tp,tp->p', x[1:], y[:-1])
+    cxx = np.einsum('tp,tp->p', x[1:], x[:-1])
+    y0, x0, y_last, x_last = y[0], x[0], y[-1], x[-1]
+
+    # Suffix sums S(j) = sum_{k >= j}; the centered totals are zero, so
+    # S(Tb) = -sum_{k < Tb}. Breaks are consecutive, so these are slices
+    lo, hi = breaks[0], breaks[-1] + 1
+    sy = -np.cumsum(y[:hi - 1], axis=0)[lo - 1:]                # S(Tb)
+    sx = -np.cumsum(x[:hi - 1], axis=0)[lo - 1:]
+    # S(Tb + 1) + S(Tb - 1) - last value, the dummy's lag-1 cross terms
+    sy_ends = 2 * sy + (y[lo - 1:hi - 1] - y[lo:hi] - y_last)
+    sx_ends = 2 * sx + (x[lo - 1:hi - 1] - x[lo:hi] - x_last)
+
+    # Level regression on (1, D, x): 2 x 2 system in the centered dummy and x
+    n2 = (n - breaks)[:, None].astype(float)                     # post-break observations
+    sdd = n2 * (1 - n2 / n)
+    with np.errstate(divide='ignore', invalid='ignore'):
+        det = sxx * sdd - sx * sx
+        b = (sxy * sdd - sy * sx) / det
+        mu = (sy * sxx - sxy * sx) / det
+    del det, sdd, sx
+    a = -mu * n2 / n
+    ssr = syy - b * sxy - mu * sy
+    del sy
+
+    # sum_k e_k e_{k-1}, k = 1..T-1, as c' C c with c = (1, -a, -mu, -b) on (y, 1, D, x)
+    e_cross = (cyy - b * (cyx + cxy) + b * b * cxx
+               + a * (y0 + y_last) - a * b * (x0 + x_last) + a * a * m
+               - mu * sy_ends + mu * b * sx_ends
+               + a * mu * (2 * n2 - 1) + mu * mu * (n2 - 1))
+    del sy_ends, sx_ends
+
+    # Dickey-Fuller sums over k = 1..T-1 from the end residuals
+    e_first = y0 - a - b * x0
+    e_last = y_last - a - mu - b * x_last
+    s_uu = ssr - e_last * e_last
+    s_vu = e_cross - s_uu
+    s_vv = ssr - e_first * e_first - 2 * e_cross + s_uu
+    with np.errstate(divide='ignore', invalid='ignore'):
+        rho = s_vu / s_uu
+        resid = np.maximum(s_vv - rho * rho * s_uu, 0)
+        adf = rho / np.sqrt(resid / (m - 1) / s_uu)
+    del s_uu, s_vu, s_vv, rho, resid, e_cross
+    adf = np.where(np.isfinite(adf), adf, np.inf)
+
+    best = adf.argmin(axis=0)
+    cols = np.arange(y.shape[1])
+    b_best, mu_best, a_best = b[best, cols], mu[best, cols], a[best, cols]
+    return {
+        'adf_stat': adf[best, cols],
+        'break_index': breaks[best],
+        'hedge_ratio': b_best,
+        'intercept': y_mean - b_best * x_mean + a_best,
+        'level_shift': mu_best,
+        'residual_std': np.sqrt(np.maximum(ssr[best, cols], 0) / (n - 3)),
+    }
+
+
+def gregory_hansen(prices: np.ndarray, idx_y: np.ndarray, idx_x: np.ndarray,
+                   trim: float = DEFAULT_TRIM, max_workers: Optional[int] = None) -> Dict[str, np.ndarray]:
+    """
+    Gregory-Hansen level-shift cointegration test (ADF*) for a batch of pairs.
+
+    Args:
+        prices: (T x N) aligned close matrix
+        idx_y: (P,) column of each pair's dependent symbol
+        idx_x: (P,) column of each pair's regressor symbol
+        trim: Fraction of the sample excluded from each end of the break search
+        max_workers: Thread count for pair chunks (default: DEFAULT_WORKERS,
+            at most the CPU count); each holds one chunk's working arrays
+
+    Returns:
+        Dictionary of (P,) arrays: 'adf_stat' (min over breaks), 'p_value'
+        (approximate, see gh_pvalues), 'break_index'
+        (first post-break row), 'hedge_ratio', 'intercept' (pre-break),
+        'level_shift' (post-break intercept minus pre-break), 'residual_std';
+        plus scalar 'n_obs' and 'critical_values' keyed by significance level
+    """
+    prices = np.asarray(prices, dtype=float)
+    idx_y, idx_x = np.asarray(idx_y), np.asarray(idx_x)
+    num_rows = len(prices)
+    first = max(int(np.floor(trim * num_rows)), 1)
+    last = min(int(np.ceil((1 - trim) * num_rows)), num_rows - 1)
+    if num_rows < 10 or last < first:
+        raise ValueError(f"Not enough observations ({num_rows}) for the break search")
+    breaks = np.arange(first, last + 1)
+
+    num_pairs = len(idx_y)
+    width = max(1, BREAK_CELLS // len(breaks))
+    chunks = [slice(i, min(i + width, num_pairs)) for i in range(0, num_pairs, width)]
+    workers = max_workers or min(len(chunks), DEFAULT_WORKERS, os.cpu_count() or 1)
+
+    def run(c: slice):
+        return _break_chunk(prices[:, idx_y[c]], prices[:, idx_x[c]], breaks)
+
+    with ThreadPoolExecutor(max_workers=max(workers, 1)) as pool:
+        parts = list(pool.map(run, chunks))
+
+    results = {key: np.concatenate([part[key] for part in parts]) if parts else np.zeros(0)
+               for key in ('adf_stat', 'break_index', 'hedge_ratio', 'intercept',
+                           'level_shift', 'residual_std')}
+    results['p_value'] = gh_pvalues(results['adf_stat'])
+    results['n_obs'] = num_rows
+    results['critical_values'] = dict(GH_CRITICAL_VALUES)
+    return results
@@ -0,0 +1,43 @@
+import numpy as np
+import pytest
+from statsmodels.tsa.stattools import coint
+
+from cointegration_engine import multi_frequency_cointegration
+
+
+@pytest.fixture
+def prices():
+    rng = np.random.default_rng(7)
+    num_obs = 600
+    common = np.cumsum(rng.standard_normal(num_obs))
+    noise = rng.standard_normal((num_obs, 3))
+    return np.column_stack([
+        100 + common + 0.5 * noise[:, 0],
+        40 + 0.7 * common + 0.5 * noise[:, 1],
+        250 + np.cumsum(noise[:, 2]),
+    ])
+
+
+@pytest.mark.parametrize('stride', [1, 5])
+def test_matches_statsmodels_coint_without_lags(prices, stride):
+    # Small blocks make the shift differ from the sample mean
+    stats = multi_frequency_cointegration(prices, strides=(stride,), block_rows=97)[stride]
+    sampled = prices[::stride]
+
+    for y in range(prices.shape[1]):
+        for x in range(prices.shape[1]):
+            if y == x:
+                continue
+            stat, p_value, crit = coint(sampled[:, y], sampled[:, x], maxlag=0, autolag=None)
+            assert stats['df_stat'][y, x] == pytest.approx(stat, rel=1e-8)
+            assert stats['p_value'][y, x] == pytest.approx(p_value, rel=1e-6, abs=1e-12)
+            np.testing.assert_allclose(stats['critical_values'], crit, rtol=1e-12)
+
+
+def test_intercepts_are_of_the_raw_series(prices):
+    stats = multi_frequency_cointegration(prices, strides=(1,), block_rows=97)[1]
+
+    for y, x in [(0, 1), (1, 0), (2, 0)]:
+        beta, alpha = np.polyfit(prices[:, x], prices[:, y], 1)
+        assert stats['hedge_ratio'][y, x] == pytest.approx(beta, rel=1e-9)
+        assert stats['intercept'][y, x] == pytest.approx(alpha, rel=1e-9)
@@ -0,0 +1,42 @@
+import numpy as np
+import pytest
+from scipy import fft
+
+from lead_lag import lead_lag_cross_correlation
+
+
+def direct_cross_correlation(r1: np.ndarray, r2: np.ndarray, max_lag: int) -> np.ndarray:
+    """Time-domain corr(r1[t + k], r2[t]) for k = -max_lag..+max_lag, divided by T."""
+    num_obs = len(r1)
+    z1 = (r1 - r1.mean()) / r1.std()
+    z2 = (r2 - r2.mean()) / r2.std()
+    out = []
+    for k in range(-max_lag, max_lag + 1):
+        if k >= 0:
+            out.append(np.dot(z1[k:], z2[:num_obs - k]))
+        else:
+            out.append(np.dot(z1[:num_obs + k], z2[-k:]))
+    return np.array(out) / num_obs
+
+
+@pytest.mark.parametrize('num_obs', [63, 200])
+def test_matches_direct_reference(num_obs):
+    max_lag = 10
+    rng = np.random.default_rng(num_obs)
+    returns = rng.standard_normal((num_obs, 3))
+    returns[3:, 1] += 0.8 * returns[:-3, 0]
+    idx1, idx2 = np.array([0, 1, 2]), np.array([1, 0, 0])
+
+    result = lead_lag_cross_correlation(returns, idx1, idx2, max_lag)
+
+    for p in range(3):
+        expected = direct_cross_correlation(returns[:, idx1[p]], returns[:, idx2[p]], max_lag)
+        np.testing.assert_allclose(result['cross_correlation'][p], expected, atol=1e-12)
+    assert result['lead_lag'][1] == 3
+    assert result['lead_lag'][0] == -3
+
+
+def test_odd_transform_length_is_exercised():
+    # T=63 with 10 lags pads to an odd fast length, the case a spectrum-derived
+    # length gets wrong
+    assert fft.next_fast_len(63 + 10, real=True) % 2 == 1
@@ -0,0 +1,295 @@
+"""
+VaR Engine - Sliding-window historical and parametric VaR/CVaR, bar by bar
+
+The live portfolio's per-bar P&L over the last lookback_var_days is kept in
+an order-statistic window, so each bar costs one insert and one delete and
+the VaR quantile and CVaR tail sum are read without sorting 30 days of
+minute P&L:
+
+- OrderStatisticWindow holds the values in sorted buckets of bounded size.
+  Binary search picks the bucket; Fenwick trees over bucket sizes and sums
+  give the k-th smallest value and the sum of the k smallest in O(log n).
+- Parametric (Gaussian) VaR/CVaR uses running sums and cross products of
+  the per-pair P&L vectors, so w^T Sigma w is available for any weights
+  in O(P^2) per bar.
+
+When the weights change (a rebalance), the historical window is revalued
+once from the stored per-pair P&L vectors.
+
+Losses are positive: VaR is minus the (1 - confidence) quantile of P&L.
+"""
+
+import bisect
+import numpy as np
+from collections import deque
+from statistics import NormalDist
+from typing import Dict, List, Optional
+
+# Target bucket size of the order-statistic window; buckets split at twice this
+BUCKET_LOAD = 256
+
+# Bars per day for the configured timeframes (FX trades around the clock)
+BARS_PER_DAY = {'M1': 1440, 'M5': 288, 'M15': 96, 'M30': 48, 'H1': 24, 'H4': 6, 'D1': 1}
+
+# Running moments are recomputed from the stored window this often (in bars)
+# so add/remove rounding does not accumulate
+MOMENT_REFRESH = 100_000
+
+
+class _Fenwick:
+    """
+    Prefix sums over a fixed-length array with point updates.
+    """
+
+    def __init__(self, values: List[float]):
+        self.tree = [0.0] + list(values)
+        n = len(self.tree)
+        for i in range(1, n):
+            parent = i + (i & -i)
+            if parent < n:
+                self.tree[parent] += self.tree[i]
+
+    def add(self, i: int, delta: float):
+        i += 1
+        n = len(self.tree)
+        while i < n:
+            self.tree[i] += delta
+            i += i & -i
+
+    def prefix(self, count: int) -> float:
+        """
+        Sum of the first `count` entries.
+        """
+        total = 0.0
+        while count > 0:
+            total += self.tree[count]
+            count -= count & -count
+        return total
+
+    def search(self, k: int):
+        """
+        (index, remainder) of the entry holding the k-th unit (0-based) of
+        a count tree, i.e. the smallest index whose prefix exceeds k.
+        """
+        position = 0
+        step = 1 << (len(self.tree) - 1).bit_length()
+        while step:
+            nxt = position + step
+            if nxt < len(self.tree) and self.tree[nxt] <= k:
+                position = nxt
+                k -= self.tree[nxt]
+            step >>= 1
+        return position, int(k)
+
+
+class OrderStatisticWindow:
+    """
+    Multiset of floats with O(log n) insert, remove, k-th smallest and
+    sum of the k smallest.
+    """
+
+    def __init__(self, load: int = BUCKET_LOAD):
+        self.load = load
+        self._buckets: List[List[float]] = []
+        self._maxes: List[float] = []
+        self._size = 0
+        self._rebuild()
+
+    def _rebuild(self):
+        self._counts = _Fenwick([len(b) for b in self._buckets])
+        self._sums = _Fenwick([sum(b) for b in self._buckets])
+
+    def __len__(self) -> int:
+        return self._size
+
+    def insert(self, value: float):
+        self._size += 1
+        if not self._buckets:
+            self._buckets.append([value])
+            self._maxes.append(value)
+            self._rebuild()
+            return
+
+        b = min(bisect.bisect_left(self._maxes, value), len(self._buckets) - 1)
+        bucket = self._buckets[b]
+        bisect.insort(bucket, value)
+        self._maxes[b] = bucket[-1]
+        self._counts.add(b, 1)
+        self._sums.add(b, value)
+
+        if len(bucket) > 2 * self.load:
+            self._buckets[b:b + 1] = [bucket[:self.load], bucket[self.load:]]
+            self._maxes[b:b + 1] = [bucket[self.load - 1], bucket[-1]]
+            self._rebuild()
+
+    def remove(self, value: float):
+        """
+        Remove one occurrence of value (KeyError if absent).
+        """
+        b = bisect.bisect_left(self._maxes, value)
+        if b == len(self._buckets):
+            raise KeyError(value)
+        bucket = self._buckets[b]
+        i = bisect.bisect_left(bucket, value)
+        if i == len(bucket) or bucket[i] != value:
+            raise KeyError(value)
+        del bucket[i]
+        self._size -= 1
+
+        if not bucket:
+            del self._buckets[b]
+            del self._maxes[b]
+            self._rebuild()
+            return
+        self._maxes[b] = bucket[-1]
+        self._counts.add(b, -1)
+        self._sums.add(b, -value)
+
+    def kth(self, k: int) -> float:
+        """
+        k-th smallest value (0-based).
+        """
+        b, offset = self._counts.search(k)
+        return self._buckets[b][offset]
+
+    def smallest_sum(self, k: int) -> float:
+        """
+        Sum of the k smallest values.
+        """
+        if k <= 0:
+            return 0.0
+        b, offset = self._counts.search(k - 1)
+        return self._sums.prefix(b) + sum(self._buckets[b][:offset + 1])
+
+
+class IncrementalVaR:
+    """
+    Historical-simulation and Gaussian VaR/CVaR of a weighted multi-pair
+    portfolio over a sliding window of bars.
+    """
+
+    def __init__(self, num_pairs: int, confidence: float = 0.95, lookback_bars: int = 30 * 1440,
+                 weights: Optional[np.ndarray] = None):
+        """
+        Args:
+            num_pairs: Number of pairs whose P&L is reported each bar
+            confidence: VaR confidence level (RISK_CONFIG var_confidence)
+            lookback_bars: Window length in bars (lookback_var_days x bars per day)
+            weights: Initial position weights (default: 1 per pair)
+        """
+        self.num_pairs = num_pairs
+        self.confidence = confidence
+        self.lookback_bars = lookback_bars
+        self.weights = np.ones(num_pairs) if weights is None else np.asarray(weights, dtype=float)
+        self._z = NormalDist().inv_cdf(confidence)
+        self._tail_density = NormalDist().pdf(self._z) / (1 - confidence)
+
+        self._pair_pnl = deque()          # (P,) vectors in arrival order
+        self._portfolio_pnl = deque()     # w . pnl at the time it entered the window
+        self._window = OrderStatisticWindow()
+        self._sum = np.zeros(num_pairs)
+        self._cross = np.zeros((num_pairs, num_pairs))
+        self._since_refresh = 0
+
+    @classmethod
+    def from_config(cls, num_pairs: int, weights: Optional[np.ndarray] = None) -> 'IncrementalVaR':
+        """
+        Engine with RISK_CONFIG var_confidence / lookback_var_days on the
+        ANALYSIS_CONFIG timeframe.
+        """
+        from config import ANALYSIS_CONFIG, RISK_CONFIG
+        bars_per_day = BARS_PER_DAY.get(ANALYSIS_CONFIG.get('timeframe', 'M1'), 1440)
+        return cls(num_pairs, confidence=RISK_CONFIG['var_confidence'],
+                   lookback_bars=int(RISK_CONFIG['lookback_var_days'] * bars_per_day),
+                   weights=weights)
+
+    def on_bar(self, pair_pnl: np.ndarray) -> float:
+        """
+        Add one bar of per-pair P&L, dropping the oldest bar once the window is full.
+
+        Returns:
+            Portfolio P&L of the bar under the current weights
+        """
+        pnl = np.asarray(pair_pnl, dtype=float).copy()
+        value = float(self.weights @ pnl)
+
+        self._pair_pnl.append(pnl)
+        self._portfolio_pnl.append(value)
+        self._window.insert(value)
+        self._sum += pnl
+        self._cross += np.outer(pnl, pnl)
+
+        if len(self._pair_pnl) > self.lookback_bars:
+            old = self._pair_pnl.popleft()
+            self._window.remove(self._portfolio_pnl.popleft())
+            self._sum -= old
+            self._cross -= np.outer(old, old)
+
+        self._since_refresh += 1
+        if self._since_refresh >= MOMENT_REFRESH:
+            self._refresh_moments()
+        return value
+
+    def set_weights(self, weights: np.ndarray):
+        """
+        New position weights; revalues the historical window once (O(n log n)).
+        """
+        self.weights = np.asarray(weights, dtype=float)
+        self._window = OrderStatisticWindow()
+        values = [float(self.weights @ pnl) for pnl in self._pair_pnl]
+        self._portfolio_pnl = deque(values)
+        for value in sorted(values):
+            self._window.insert(value)
+
+    def _refresh_moments(self):
+        if self._pair_pnl:
+            stacked = np.array(self._pair_pnl)
+            self._sum = stacked.sum(axis=0)
+            self._cross = stacked.T @ stacked
+        self._since_refresh = 0
+
+    def historical(self) -> Dict[str, float]:
+        """
+        Historical-simulation VaR and CVaR (expected shortfall) of the window.
+        """
+        n = len(self._window)
+        if n == 0:
+            return {'var': np.nan, 'cvar': np.nan, 'observations': 0}
+        # Tail size; the epsilon keeps (1 - 0.95) * 43200 from rounding up to 2161
+        k = max(1, int(np.ceil((1 - self.confidence) * n - 1e-9)))
+        return {
+            'var': -self._window.kth(k - 1),
+            'cvar': -self._window.smallest_sum(k) / k,
+            'observations': n,
+        }
+
+    def parametric(self) -> Dict[str, float]:
+        """
+        Gaussian VaR and CVaR from the window's mean and covariance.
+        """
+        n = len(self._pair_pnl)
+        if n < 2:
+            return {'var': np.nan, 'cvar': np.nan, 'observations': n}
+        mean = self._sum / n
+        cov = (self._cross - n * np.outer(mean, mean)) / (n - 1)
+        mu = float(self.weights @ mean)
+        sigma = float(np.sqrt(max(self.weights @ cov @ self.weights, 0.0)))
+        return {
+            'var': self._z * sigma - mu,
+            'cvar': self._tail_density * sigma - mu,
+            'observations': n,
+        }
+
+    def report(self) -> Dict[str, float]:
+        """
+        Both estimates, flattened ('hist_var', 'hist_cvar', 'param_var', 'param_cvar').
+        """
+        hist, param = self.historical(), self.parametric()
+        return {
+            'confidence': self.confidence,
+            'observations': hist['observations'],
+            'hist_var': hist['var'],
+            'hist_cvar': hist['cvar'],
+            'param_var': param['var'],
+            'param_cvar': param['cvar'],
+        }